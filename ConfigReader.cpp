@@ -3,6 +3,37 @@
 #include <iostream>
 #include <sstream>
 #include <map>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+RawSumBound rawSumBound(float threshold, int count) {
+    RawSumBound bound;
+    bound.count = count;
+    if (count <= 0) {
+        return bound;
+    }
+
+    // The float path sums count terms fl(raw / 64 - 273.15f) and divides once. Each term is at
+    // most 750.83 C in magnitude (raw 0 or 65535), so the computed mean is within
+    // gamma(count + 1) * 750.83 of the exact one, plus one rounding of the division
+    // (Higham's bound for recursive summation; doubled here to stay clear of it)
+    const double u = std::ldexp(1.0, -24);
+    const double offset = static_cast<double>(273.15f);
+    const double largest = 65535.0 / 64.0 - offset;
+    const double n = static_cast<double>(count);
+    const double gamma = (n + 1.0) * u / (1.0 - (n + 1.0) * u);
+    const double error = 2.0 * (gamma * largest + u * largest * (1.0 + gamma));
+
+    // mean = sum / (64 n) - 273.15f, so mean >= t  <=>  sum >= 64 n (t + 273.15f)
+    // A threshold beyond every possible mean (infinite or huge), or NaN, which no mean reaches,
+    // is moved just past the range so the bounds stay finite and keep the same verdicts
+    const double t = std::isnan(threshold) ? largest + 1.0 : std::min(std::max(static_cast<double>(threshold), -offset - 1.0), largest + 1.0);
+    const double scale = 64.0 * n;
+    bound.below = static_cast<int64_t>(std::floor(scale * (t + offset - error)));
+    bound.above = static_cast<int64_t>(std::ceil(scale * (t + offset + error))) + 1;
+    return bound;
+}
 
 // Implementacja funkcji readConfig
 Config readConfig(const std::string &filename) {
@@ -15,16 +46,27 @@ Config readConfig(const std::string &filename) {
 
     std::string line;
     std::map<std::string, std::string> configMap;
+    std::vector<std::pair<std::string, std::string>> roiLines;  // kept in file order
     while (std::getline(file, line)) {
         if (line.empty() || line[0] == '#') continue;  // Skip empty lines and comments
 
         std::istringstream iss(line);
         std::string key, equalSign, value;
         if (iss >> key >> equalSign >> value && equalSign == "=") {
-            configMap[key] = value;
+            if (key.rfind("roi_", 0) == 0) {
+                roiLines.emplace_back(key.substr(4), value);
+            } else {
+                configMap[key] = value;
+            }
         }
     }
 
+    // Optional keys fall back to their default value
+    auto optional = [&configMap](const std::string &key, const std::string &defaultValue) {
+        auto it = configMap.find(key);
+        return it == configMap.end() ? defaultValue : it->second;
+    };
+
     // Convert the string values to appropriate types and store in the config struct
     config.drill_start_x = std::stoi(configMap["drill_start_x"]);
     config.drill_start_y = std::stoi(configMap["drill_start_y"]);
@@ -35,6 +77,61 @@ Config readConfig(const std::string &filename) {
     config.hotspot_y = std::stoi(configMap["hotspot_y"]);
     config.hotspot_size = std::stoi(configMap["hotspot_size"]);
     config.hotspot_temp_threshold = std::stof(configMap["hotspot_temp_threshold"]);
+    config.hotspot_raw_bound = rawSumBound(config.hotspot_temp_threshold, config.hotspot_size * config.hotspot_size);
+    config.frame_outputs = optional("frame_outputs", "all");
+
+    // Hot spot location: fixed (hotspot_x/hotspot_y) or auto (located in every frame)
+    std::string hotspotMode = optional("hotspot_mode", "fixed");
+    if (hotspotMode != "fixed" && hotspotMode != "auto") {
+        std::cerr << "Error: Invalid hotspot_mode: " << hotspotMode << " (expected fixed or auto)" << std::endl;
+    }
+    config.hotspot_auto = hotspotMode == "auto";
+    // hotspot_search only bounds the hot area count; the spot is always searched in the whole frame
+    config.hotspot_search = std::max(std::stoi(optional("hotspot_search", "16")), 0);
+    config.hotspot_filter = std::max(std::stoi(optional("hotspot_filter", "0")), 0);
+    config.png_filter = optional("png_filter", "default");
+    config.jpg_quality = std::stoi(optional("jpg_quality", "95"));
+
+    // PNG compression: a zlib level or one of the names below
+    std::string compression = optional("png_compression", "default");
+    if (compression == "default") {
+        config.png_compression_level = -1;
+    } else if (compression == "store") {
+        config.png_compression_level = 0;
+    } else if (compression == "fast") {
+        config.png_compression_level = 1;
+    } else if (compression == "max") {
+        config.png_compression_level = 9;
+    } else {
+        config.png_compression_level = std::stoi(compression);
+    }
+
+    // Named ROIs: x,y,width,height and an optional threshold (default: hotspot_temp_threshold)
+    for (const auto &roiLine : roiLines) {
+        std::vector<std::string> fields;
+        std::istringstream values(roiLine.second);
+        std::string field;
+        while (std::getline(values, field, ',')) {
+            fields.push_back(field);
+        }
+
+        RoiConfig roi;
+        roi.name = roiLine.first;
+        try {
+            if (fields.size() < 4 || fields.size() > 5) {
+                throw std::invalid_argument("expected x,y,width,height[,threshold]");
+            }
+            roi.x = std::stoi(fields[0]);
+            roi.y = std::stoi(fields[1]);
+            roi.width = std::stoi(fields[2]);
+            roi.height = std::stoi(fields[3]);
+            roi.threshold = fields.size() == 5 ? std::stof(fields[4]) : config.hotspot_temp_threshold;
+        } catch (const std::exception &e) {
+            std::cerr << "Error: Invalid ROI roi_" << roi.name << " = " << roiLine.second << " (" << e.what() << ")" << std::endl;
+            continue;
+        }
+        config.rois.push_back(roi);
+    }
 
     return config;
 }
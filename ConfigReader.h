@@ -1,7 +1,31 @@
 #ifndef CONFIGREADER_H
 #define CONFIGREADER_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
+
+// Nazwany prostokątny obszar (ROI) z własnym progiem temperatury
+struct RoiConfig {
+    std::string name;
+    int x;
+    int y;
+    int width;
+    int height;
+    float threshold;
+};
+
+// A temperature threshold as a bound on the sum of `count` raw words (t = raw / 64 - 273.15).
+// Sums below `below` are under the threshold and sums at or above `above` reach it whatever the
+// float rounding of the Celsius mean; only the few sums in between need the float path.
+struct RawSumBound {
+    int count = 0;
+    int64_t below = 0;
+    int64_t above = 0;
+};
+
+// Function to compute the raw sum bound of a threshold for a region of `count` pixels
+RawSumBound rawSumBound(float threshold, int count);
 
 // Struktura Config zawierająca wszystkie konfiguracje
 struct Config {
@@ -14,6 +38,15 @@ struct Config {
     int hotspot_y;
     int hotspot_size;
     float hotspot_temp_threshold;
+    RawSumBound hotspot_raw_bound;  // hotspot_temp_threshold for the full hotspot_size square
+    bool hotspot_auto;            // hotspot_mode = auto: locate the hot spot in every frame (HotspotTracker)
+    int hotspot_search;           // auto: radius of the hot area count around the peak (not a search window), 0 = whole frame
+    int hotspot_filter;           // auto: side of the box filter, 0 or 1 = hottest single pixel
+    std::string frame_outputs;  // mtpFrame output files, e.g. "16bit,8bit,lin,csv,jpg", "all" or "none"
+    std::vector<RoiConfig> rois;  // roi_<name> = x,y,width,height[,threshold] in file order
+    int png_compression_level;    // zlib level 0-9, -1 = libpng default
+    std::string png_filter;       // none, sub, up, avg, paeth, all or default
+    int jpg_quality;              // JPEG quality of the visible image (0-100)
 };
 
 // Deklaracja funkcji readConfig
@@ -0,0 +1,47 @@
+#include "FalseColor.h"
+
+#include <algorithm>
+#include <cstring>
+
+void FalseColorLut::build(float minTemp, float maxTemp, int colormap) {
+    minTemp_ = minTemp;
+    maxTemp_ = maxTemp;
+
+    // The 256 colours of the palette
+    cv::Mat ramp(1, 256, CV_8UC1);
+    for (int i = 0; i < 256; ++i) {
+        ramp.ptr<uint8_t>(0)[i] = static_cast<uint8_t>(i);
+    }
+    cv::Mat palette;
+    cv::applyColorMap(ramp, palette, colormap);
+
+    // Every raw word through the _lin.png scaling (a flat range maps everything to colour 0)
+    const float range = maxTemp - minTemp;
+    const bool flat = !(range > 0.0f);
+    table_.resize(65536 * 3);
+    for (int raw = 0; raw < 65536; ++raw) {
+        float temp = static_cast<float>(raw) / 64.0f - 273.15f;
+        int index = flat ? 0 : static_cast<uint8_t>(std::min(std::max((temp - minTemp) / range * 255.0f, 0.0f), 255.0f));
+        std::memcpy(&table_[static_cast<size_t>(raw) * 3], palette.ptr<uint8_t>(0) + index * 3, 3);
+    }
+}
+
+bool FalseColorLut::apply(RawSpan temperatureData, int rows, int cols, cv::Mat &bgr) const {
+    const int height = rows / 2;
+    bgr.create(height, cols, CV_8UC3);
+    if (temperatureData.size < static_cast<size_t>(height) * cols) {
+        return false;
+    }
+    const uint8_t *table = table_.data();
+    for (int y = 0; y < height; ++y) {
+        const uint16_t *src = temperatureData.data + static_cast<size_t>(y) * cols;
+        uint8_t *dst = bgr.ptr<uint8_t>(y);
+        for (int x = 0; x < cols; ++x) {
+            const uint8_t *colour = table + static_cast<size_t>(src[x]) * 3;
+            dst[3 * x] = colour[0];
+            dst[3 * x + 1] = colour[1];
+            dst[3 * x + 2] = colour[2];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef FALSECOLOR_H
+#define FALSECOLOR_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "Tc0File.h"
+
+// False-colour table of the raw temperature words for one temperature range. Every raw word
+// (65536 entries) maps straight to its BGR colour: the word is scaled like the _lin.png image
+// (0-255 over [minTemp, maxTemp], clamped) and looked up in the 256 colours of an OpenCV
+// colormap. A frame is then coloured with one table lookup per pixel, with no float math.
+class FalseColorLut {
+public:
+    // Function to build the table for a range in Celsius and a cv::COLORMAP_* palette
+    void build(float minTemp, float maxTemp, int colormap = cv::COLORMAP_INFERNO);
+
+    // Function to colour the raw temperature half of a rows x cols .tc0 frame into a BGR image
+    // of rows/2 x cols (the buffer of `bgr` is reused); false if the data is too short
+    bool apply(RawSpan temperatureData, int rows, int cols, cv::Mat &bgr) const;
+
+    float minTemp() const { return minTemp_; }
+    float maxTemp() const { return maxTemp_; }
+
+private:
+    std::vector<uint8_t> table_;  // 3 bytes (B, G, R) per raw word
+    float minTemp_ = 0.0f;
+    float maxTemp_ = 0.0f;
+};
+
+#endif // FALSECOLOR_H
@@ -0,0 +1,272 @@
+#include "FrameIndex.h"
+#include "TcsArchive.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <sys/stat.h>
+
+const char *FrameIndex::FILENAME = ".mtpSeries.idx";
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'M', 'T', 'P', 'I', 'D', 'X', '\0', '\0'};
+const uint32_t INDEX_VERSION = 3;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t geometryKey;
+    uint64_t roiCount;     // entries of the ROI table
+    uint64_t stringBytes;
+};
+
+struct IndexRecord {
+    uint64_t size;
+    int64_t mtime;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    float hotspotMean;
+    float minTemp;
+    float maxTemp;
+    float drillMax;
+    int32_t valid;
+    uint32_t hasRois;
+    uint32_t roisOffset;  // first ROI of the frame in the ROI table
+    uint32_t roisLength;  // number of ROIs (config order)
+};
+
+struct IndexRoi {
+    float mean;
+    float stddev;
+    int32_t count;
+};
+
+static_assert(sizeof(IndexHeader) == 40, "IndexHeader layout");
+static_assert(sizeof(IndexRecord) == 56, "IndexRecord layout");
+static_assert(sizeof(IndexRoi) == 12, "IndexRoi layout");
+
+// FNV-1a over a sequence of integers
+uint64_t hashInts(std::initializer_list<int64_t> values) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int64_t v : values) {
+        for (int i = 0; i < 8; ++i) {
+            h ^= static_cast<uint64_t>(v >> (8 * i)) & 0xFF;
+            h *= 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+} // namespace
+
+uint64_t frameGeometryKey(const Config &config) {
+    uint64_t key = hashInts({INDEX_VERSION, config.hotspot_x, config.hotspot_y, config.hotspot_size,
+                             config.drill_start_x, config.drill_start_y, config.drill_end_x, config.drill_end_y,
+                             config.drill_width});
+    // A located hot spot (searched in the whole frame) also depends on the box filter; the
+    // threshold and hotspot_search only shape the hot area, which is not cached (fixed mode keeps its key)
+    if (config.hotspot_auto) {
+        key ^= hashInts({config.hotspot_filter});
+    }
+    // The cached ROI statistics depend on the ROI rectangles in config order (none keeps the key);
+    // names and thresholds are applied when the verdicts are printed
+    for (size_t i = 0; i < config.rois.size(); ++i) {
+        const auto &roi = config.rois[i];
+        key ^= hashInts({static_cast<int64_t>(i), roi.x, roi.y, roi.width, roi.height});
+    }
+    return key;
+}
+
+bool fileKey(const std::string &filename, uint64_t &size, int64_t &mtime) {
+    // A frame of an archive is keyed by its stored size and the timestamp recorded when packing
+    std::string archivePath, name;
+    if (splitArchiveMember(filename, archivePath, name)) {
+        auto archive = TcsArchive::shared(archivePath);
+        long index = archive ? archive->find(name) : -1;
+        if (index < 0) {
+            return false;
+        }
+        size = archive->frame(index).storedSize;
+        mtime = archive->frame(index).timestamp;
+        return true;
+    }
+
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool FrameIndex::load(const std::string &path, uint64_t geometryKey) {
+    StageTimer timer(STAGE_INDEX);
+    entries_.clear();
+    geometryKey_ = geometryKey;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    IndexHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+        || header.version != INDEX_VERSION || header.geometryKey != geometryKey) {
+        return false;
+    }
+
+    // The records, ROIs and names must be exactly what follows the header, before anything is allocated
+    file.seekg(0, std::ios::end);
+    uint64_t payloadBytes = static_cast<uint64_t>(file.tellg()) - sizeof(header);
+    if (header.stringBytes > payloadBytes || header.roiCount > (payloadBytes - header.stringBytes) / sizeof(IndexRoi)
+        || static_cast<uint64_t>(header.count) * sizeof(IndexRecord) != payloadBytes - header.stringBytes - header.roiCount * sizeof(IndexRoi)) {
+        return false;
+    }
+    file.seekg(sizeof(header));
+
+    std::vector<IndexRecord> records(header.count);
+    std::vector<IndexRoi> rois(header.roiCount);
+    std::string names(header.stringBytes, '\0');
+    if (!file.read(reinterpret_cast<char *>(records.data()), records.size() * sizeof(IndexRecord))
+        || !file.read(reinterpret_cast<char *>(rois.data()), rois.size() * sizeof(IndexRoi))
+        || !file.read(&names[0], names.size())) {
+        return false;
+    }
+
+    entries_.reserve(records.size());
+    for (const auto &r : records) {
+        if (static_cast<uint64_t>(r.nameOffset) + r.nameLength > names.size()
+            || static_cast<uint64_t>(r.roisOffset) + r.roisLength > rois.size()) {
+            entries_.clear();
+            return false;
+        }
+        FrameStats stats;
+        stats.hotspotMean = r.hotspotMean;
+        stats.minTemp = r.minTemp;
+        stats.maxTemp = r.maxTemp;
+        stats.drillMax = r.drillMax;
+        stats.valid = r.valid != 0;
+        Entry &entry = entries_[names.substr(r.nameOffset, r.nameLength)];
+        entry = Entry{r.size, r.mtime, stats, r.hasRois != 0, {}};
+        for (uint32_t k = 0; r.hasRois && k < r.roisLength; ++k) {
+            const IndexRoi &roi = rois[r.roisOffset + k];
+            RoiStats roiStats;
+            roiStats.mean = roi.mean;
+            roiStats.stddev = roi.stddev;
+            roiStats.count = roi.count;
+            entry.rois.push_back(roiStats);
+        }
+    }
+    return true;
+}
+
+bool FrameIndex::save(const std::string &path) const {
+    StageTimer timer(STAGE_INDEX);
+
+    // Records sorted by name, like the frames of the directory
+    std::vector<const std::pair<const std::string, Entry> *> sorted;
+    sorted.reserve(entries_.size());
+    for (const auto &e : entries_) {
+        sorted.push_back(&e);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto *a, const auto *b) { return a->first < b->first; });
+
+    std::vector<IndexRecord> records;
+    std::vector<IndexRoi> rois;
+    std::string names;
+    records.reserve(sorted.size());
+    for (const auto *e : sorted) {
+        const FrameStats &s = e->second.stats;
+        IndexRecord r{};
+        r.size = e->second.size;
+        r.mtime = e->second.mtime;
+        r.nameOffset = static_cast<uint32_t>(names.size());
+        r.nameLength = static_cast<uint32_t>(e->first.size());
+        r.hotspotMean = s.hotspotMean;
+        r.minTemp = s.minTemp;
+        r.maxTemp = s.maxTemp;
+        r.drillMax = s.drillMax;
+        r.valid = s.valid ? 1 : 0;
+        names += e->first;
+        if (e->second.hasRois) {
+            r.hasRois = 1;
+            r.roisOffset = static_cast<uint32_t>(rois.size());
+            r.roisLength = static_cast<uint32_t>(e->second.rois.size());
+            for (const RoiStats &roi : e->second.rois) {
+                rois.push_back(IndexRoi{roi.mean, roi.stddev, roi.count});
+            }
+        }
+        records.push_back(r);
+    }
+
+    IndexHeader header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.count = static_cast<uint32_t>(records.size());
+    header.geometryKey = geometryKey_;
+    header.roiCount = rois.size();
+    header.stringBytes = names.size();
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Error: Could not write index file: " << tmpPath << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(IndexRecord));
+        file.write(reinterpret_cast<const char *>(rois.data()), rois.size() * sizeof(IndexRoi));
+        file.write(names.data(), names.size());
+        if (!file) {
+            std::cerr << "Error: Could not write index file: " << tmpPath << std::endl;
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error: Could not replace index file: " << path << std::endl;
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    countStats(COUNTER_FILES_WRITTEN);
+    countStats(COUNTER_BYTES_WRITTEN, sizeof(header) + records.size() * sizeof(IndexRecord) + rois.size() * sizeof(IndexRoi) + names.size());
+    return true;
+}
+
+const FrameStats *FrameIndex::find(const std::string &name, uint64_t size, int64_t mtime, const std::vector<RoiStats> **rois) const {
+    auto it = entries_.find(name);
+    if (it == entries_.end() || it->second.size != size || it->second.mtime != mtime || (rois && !it->second.hasRois)) {
+        return nullptr;
+    }
+    if (rois) {
+        *rois = &it->second.rois;
+    }
+    return &it->second.stats;
+}
+
+void FrameIndex::retain(const std::vector<std::string> &names) {
+    std::unordered_map<std::string, Entry> kept;
+    kept.reserve(names.size());
+    for (const auto &name : names) {
+        auto it = entries_.find(name);
+        if (it != entries_.end()) kept.emplace(name, it->second);
+    }
+    entries_.swap(kept);
+}
+
+void FrameIndex::put(const std::string &name, uint64_t size, int64_t mtime, const FrameStats &stats, const std::vector<RoiStats> *rois) {
+    Entry &entry = entries_[name];
+    // Without new ROI statistics, those of the unchanged file are kept
+    bool keepRois = !rois && entry.hasRois && entry.size == size && entry.mtime == mtime;
+    entry = Entry{size, mtime, stats, rois != nullptr || keepRois, rois ? *rois : keepRois ? std::move(entry.rois) : std::vector<RoiStats>()};
+}
@@ -0,0 +1,65 @@
+#ifndef FRAMEINDEX_H
+#define FRAMEINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ConfigReader.h"
+#include "FrameProcessor.h"
+#include "RoiEngine.h"
+
+// Sidecar file with the per-frame statistics of one recording directory, so that re-runs of
+// mtpSeries only decode new or changed .tc0 files. Frames are keyed by file name, size and
+// modification time; the whole index is dropped when the ROI/drill geometry in config.txt
+// changes (thresholds are evaluated against the cached statistics and do not invalidate it;
+// the mean and stddev of every roi_* rectangle are cached too and judged when printed).
+//
+// File layout (little endian): IndexHeader, count x IndexRecord, ROI table, string table with the names.
+class FrameIndex {
+public:
+    static const char *FILENAME;  // name of the sidecar file inside the recording directory
+
+    // Function to load the index; a missing, corrupt or stale (other geometry) file gives an empty index
+    bool load(const std::string &path, uint64_t geometryKey);
+
+    // Function to write the index (to a temporary file that is then renamed)
+    bool save(const std::string &path) const;
+
+    // Function to return the cached statistics of a frame, or nullptr if missing or changed.
+    // With `rois` given, a frame also needs its cached ROI statistics, which are returned there.
+    // Safe to call concurrently (the lookup itself does not modify the index).
+    const FrameStats *find(const std::string &name, uint64_t size, int64_t mtime, const std::vector<RoiStats> **rois = nullptr) const;
+
+    // Function to drop the entries of files that are not in the list (deleted frames)
+    void retain(const std::vector<std::string> &names);
+
+    // Function to add or replace the statistics (and the ROI statistics, if measured) of a frame;
+    // without `rois`, those cached for the same size and mtime are kept
+    void put(const std::string &name, uint64_t size, int64_t mtime, const FrameStats &stats, const std::vector<RoiStats> *rois = nullptr);
+
+    size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        uint64_t size;
+        int64_t mtime;
+        FrameStats stats;
+        bool hasRois;
+        std::vector<RoiStats> rois;  // one per roi_* entry, in config order
+    };
+
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t geometryKey_ = 0;
+};
+
+// Function to hash the config values the cached statistics depend on (hot spot and drill geometry,
+// plus the box filter in hotspot_mode = auto and the ROI rectangles)
+uint64_t frameGeometryKey(const Config &config);
+
+// Function to read the size and modification time (ns) of a file
+// (for a frame of an archive: its stored size and packed timestamp)
+bool fileKey(const std::string &filename, uint64_t &size, int64_t &mtime);
+
+#endif // FRAMEINDEX_H
@@ -0,0 +1,90 @@
+#include "FramePipeline.h"
+#include "FramePool.h"
+
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// Frame handed from the reader to the workers
+struct LoadedFrame {
+    std::size_t index = 0;
+    FramePool *pool = nullptr;
+    bool opened = false;  // false: the frame could not be opened (reported as -1)
+};
+
+} // namespace
+
+void runFramePipeline(const std::vector<std::string> &inputs, const Config &config, int outputs, int workers, int depth,
+                      const std::function<void(const std::string &, const FrameOutcome &)> &report) {
+    workers = std::max(workers, 1);
+    depth = std::max(depth, 1);
+    const std::size_t poolCount = static_cast<std::size_t>(workers + depth);
+
+    std::vector<FramePool> pools(poolCount);
+    BoundedQueue<FramePool *> freePools(poolCount);
+    BoundedQueue<LoadedFrame> loaded(poolCount);
+    BoundedQueue<FrameOutcome> done(poolCount);
+    for (auto &pool : pools) {
+        freePools.push(&pool);
+    }
+
+    // Reader: read-ahead hints, then open and read in one frame per free pool
+    std::thread reader([&] {
+        std::size_t advised = 0;
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            while (advised < inputs.size() && advised < i + static_cast<std::size_t>(depth)) {
+                adviseFrameFile(inputs[advised++]);
+            }
+            LoadedFrame frame;
+            if (!freePools.pop(frame.pool)) {
+                break;
+            }
+            frame.index = i;
+            frame.opened = frame.pool->file.open(inputs[i]);
+            if (frame.opened) {
+                frame.pool->file.load();
+            }
+            loaded.push(frame);
+        }
+        loaded.close();
+    });
+
+    // Workers: the rest of the frame pipeline, on whichever frame comes next (a located hot spot
+    // depends on its frame only, so the order the workers take the frames in does not matter)
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; ++w) {
+        threads.emplace_back([&] {
+            LoadedFrame frame;
+            while (loaded.pop(frame)) {
+                FrameOutcome outcome;
+                outcome.index = frame.index;
+                if (frame.opened) {
+                    outcome.result = processOpenFrame(inputs[frame.index], config, outputs, &outcome.rois, *frame.pool, &outcome.hotspotMean,
+                                                      &outcome.hotspot);
+                }
+                freePools.push(frame.pool);
+                done.push(std::move(outcome));
+            }
+        });
+    }
+
+    // Results in input order (only the frames finished ahead of an earlier one wait here)
+    std::map<std::size_t, FrameOutcome> pending;
+    std::size_t next = 0;
+    FrameOutcome outcome;
+    while (next < inputs.size() && done.pop(outcome)) {
+        pending.emplace(outcome.index, std::move(outcome));
+        for (auto it = pending.begin(); it != pending.end() && it->first == next; it = pending.erase(it), ++next) {
+            report(inputs[next], it->second);
+        }
+    }
+
+    freePools.close();
+    reader.join();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
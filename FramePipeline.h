@@ -0,0 +1,77 @@
+#ifndef FRAMEPIPELINE_H
+#define FRAMEPIPELINE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ConfigReader.h"
+#include "FrameProcessor.h"
+
+// FIFO between two pipeline stages holding at most `capacity` items: push() waits while it is
+// full (backpressure on the producer), pop() waits while it is empty. After close() pushes are
+// dropped and pop() returns false once the remaining items are taken.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity_(capacity) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this] { return items_.size() < capacity_ || closed_; });
+        if (closed_) return;
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+    }
+
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this] { return !items_.empty() || closed_; });
+        if (items_.empty()) return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+private:
+    std::deque<T> items_;
+    std::size_t capacity_;
+    bool closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
+
+// Result of one frame of a pipelined batch (what processFrame returns and reports)
+struct FrameOutcome {
+    std::size_t index = 0;  // position in the input list
+    int result = -1;
+    float hotspotMean = 0.0f;
+    std::vector<RoiResult> rois;
+    HotspotLocation hotspot;
+};
+
+// Function to run processFrame on every input with reading and processing overlapped:
+//   reader   hints the kernel to read `depth` frames ahead (posix_fadvise), opens the next frame
+//            into a free buffer pool and reads it in completely
+//   workers  `workers` threads convert, quantize, encode (on the shared task pool) and write
+//            the frames handed over by the reader
+//   report   called on the calling thread for every frame, in input order
+// Every frame in flight owns one FramePool; there are workers + depth of them, so memory stays
+// bounded and the reader waits for a free pool when the workers fall behind.
+void runFramePipeline(const std::vector<std::string> &inputs, const Config &config, int outputs, int workers, int depth,
+                      const std::function<void(const std::string &, const FrameOutcome &)> &report);
+
+#endif // FRAMEPIPELINE_H
@@ -0,0 +1,73 @@
+#include "FramePool.h"
+#include "Stats.h"
+
+namespace {
+
+std::uintptr_t address(const void *p) {
+    return reinterpret_cast<std::uintptr_t>(p);
+}
+
+// Function to reserve the encoded size of an image: stored deflate blocks, chunk headers and text
+void reservePng(PngBuffers &png, int height, std::size_t rowBytes) {
+    std::size_t raw = static_cast<std::size_t>(height) * (rowBytes + 1);  // filter byte per row
+    png.bytes.reserve(raw + raw / 256 + 4096);
+    png.rows.reserve(height);
+}
+
+} // namespace
+
+void FramePool::prepare(int rows, int cols) {
+    if (rows == rows_ && cols == cols_) {
+        return;
+    }
+    rows_ = rows;
+    cols_ = cols;
+
+    // Both halves of the frame are rows/2 x cols
+    int height = rows / 2;
+    std::size_t pixels = static_cast<std::size_t>(height) * cols;
+
+    temperature.resize(cols, height);
+    images.img_16bit.create(height, cols, CV_16UC1);
+    images.img_8bit.create(height, cols, CV_8UC1);
+    images.img_lin.create(height, cols, CV_8UC1);
+    reservePng(png16, height, static_cast<std::size_t>(cols) * 2);
+    reservePng(png8, height, cols);
+    reservePng(pngLin, height, cols);
+    bgr.create(height, cols, CV_8UC3);
+    jpeg.reserve(pixels * 3);
+    csv.reserve(static_cast<std::size_t>(height) * (static_cast<std::size_t>(cols) * 12 + 1));
+    npy.reserve(128 + pixels * sizeof(float));
+    table.reserve(cols, height);
+    tasks.reserve(6);
+
+    account();
+}
+
+void FramePool::recycle() {
+    account();
+}
+
+FramePool::Footprint FramePool::footprint() const {
+    // Matrices are compared by address (create() keeps it for the same size),
+    // the other buffers by capacity (it only changes when they are reallocated)
+    return Footprint{{
+        temperature.capacity(),
+        address(images.img_16bit.data), address(images.img_8bit.data), address(images.img_lin.data),
+        png16.bytes.capacity(), png16.rows.capacity(), png16.arena.capacity(),
+        png8.bytes.capacity(), png8.rows.capacity(), png8.arena.capacity(),
+        pngLin.bytes.capacity(), pngLin.rows.capacity(), pngLin.arena.capacity(),
+        address(bgr.data), jpeg.capacity(), csv.capacity(), npy.capacity(),
+        table.capacity(), tasks.capacity()}};
+}
+
+void FramePool::account() {
+    Footprint current = footprint();
+    std::size_t changed = 0;
+    for (std::size_t i = 0; i < FOOTPRINT_SIZE; ++i) {
+        changed += current[i] != footprint_[i];
+    }
+    footprint_ = current;
+    allocations_ += changed;
+    countStats(COUNTER_POOL_ALLOCATIONS, changed);
+}
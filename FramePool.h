@@ -0,0 +1,66 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "FrameProcessor.h"
+#include "Tc0File.h"
+#include "ThermalFrame.h"
+#include "RoiEngine.h"
+#include "HotspotTracker.h"
+
+// Buffers of every pipeline stage of one frame, kept by one worker and recycled from frame to frame.
+// prepare() sizes them for a (rows, cols) .tc0 frame; as long as the size does not change no
+// buffer is reallocated. allocations() counts every time one of these buffers had to be
+// (re)allocated, so a batch over frames of one size stays at the count of its first frame
+// (--stats adds them up over all pools as pool_allocations).
+// A pool is used by one thread at a time (the output tasks of a frame share it while it runs).
+class FramePool {
+public:
+    // Function to size all buffers for a rows x cols .tc0 frame (no-op for the current size)
+    void prepare(int rows, int cols);
+
+    // Function to end a frame: counts the buffers that had to grow while it was processed
+    void recycle();
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+    // Buffer (re)allocations of this pool
+    std::size_t allocations() const { return allocations_; }
+
+    Tc0File file;               // mapped input (read buffer when it cannot be mapped)
+    ThermalFrame temperature;   // temperature matrix in Celsius
+    TemperatureImages images;   // quantized 16bit/8bit/lin images
+    PngBuffers png16;           // one encoder state per image, the PNGs are encoded concurrently
+    PngBuffers png8;
+    PngBuffers pngLin;
+    cv::Mat bgr;                // visible image converted from YUYV
+    std::vector<uint8_t> jpeg;  // encoded visible image
+    std::string csv;            // formatted temperature matrix
+    std::string npy;            // .npy header and data
+    SummedAreaTable table;      // ROI tables
+    HotspotTracker tracker;     // hot spot search buffers (hotspot_mode = auto)
+    std::vector<std::function<void()>> tasks;  // output writes of the frame
+
+private:
+    static const std::size_t FOOTPRINT_SIZE = 19;
+    typedef std::array<std::uintptr_t, FOOTPRINT_SIZE> Footprint;
+
+    // Function to capture the address or capacity of every buffer (any change means a reallocation)
+    Footprint footprint() const;
+    void account();
+
+    Footprint footprint_ = {};
+    std::size_t allocations_ = 0;
+    int rows_ = 0;
+    int cols_ = 0;
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,751 @@
+#include "FrameProcessor.h"
+#include "FramePool.h"
+#include "ParallelFor.h"
+#include "TcsArchive.h"
+#include "Stats.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <cstdlib>
+#include <png.h>
+#include <string>
+#include <charconv>
+#include <sstream>
+#include <map>
+#include <functional>
+
+// Function to load raw data from the file and split it into image and temperature matrices
+bool loadDataFromFile(const std::string &filename, std::vector<uint16_t> &imageData, std::vector<uint16_t> &temperatureData, int &rows, int &cols) {
+    // Map the file and validate its header
+    Tc0File file;
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    rows = file.rows();
+    cols = file.cols();
+
+    // Copy the image (upper half) and temperature (lower half) views
+    RawSpan image = file.imageData();
+    RawSpan temperature = file.temperatureData();
+    imageData.assign(image.begin(), image.end());
+    temperatureData.assign(temperature.begin(), temperature.end());
+
+    return true;
+}
+
+// Function to convert raw temperature data to a temperature matrix in Celsius
+void convertToTemperature(RawSpan temperatureData, int rows, int cols, ThermalFrame &temperatureMatrix) {
+    StageTimer timer(STAGE_CONVERT);
+    temperatureMatrix.resize(cols, rows / 2);
+
+    // Convert each row using the formula: t = x / 64 - 273.15
+    for (int i = 0; i < rows / 2; ++i) {
+        rawToCelsius(temperatureData.data + static_cast<size_t>(i) * cols, temperatureMatrix.row(i), cols);
+    }
+}
+
+ThermalFrame convertToTemperature(RawSpan temperatureData, int rows, int cols) {
+    ThermalFrame temperatureMatrix;
+    convertToTemperature(temperatureData, rows, cols, temperatureMatrix);
+    return temperatureMatrix;
+}
+
+// Function to map the png_compression/png_filter config values to encoder options
+PngOptions pngOptionsFromConfig(const Config &config) {
+    static const std::map<std::string, int> filters = {
+        {"none", PNG_FILTER_NONE}, {"sub", PNG_FILTER_SUB}, {"up", PNG_FILTER_UP},
+        {"avg", PNG_FILTER_AVG}, {"paeth", PNG_FILTER_PAETH}, {"all", PNG_ALL_FILTERS}};
+
+    PngOptions options;
+    options.compressionLevel = config.png_compression_level;
+    auto it = filters.find(config.png_filter);
+    if (it != filters.end()) {
+        options.filters = it->second;
+    }
+    return options;
+}
+
+namespace {
+
+// Encoder buffers of the overload without a pool; thread_local, so every encoder thread reuses its own
+thread_local PngBuffers threadPngBuffers;
+
+void appendPngData(png_structp png, png_bytep data, png_size_t length) {
+    auto *buffer = static_cast<std::vector<uint8_t> *>(png_get_io_ptr(png));
+    buffer->insert(buffer->end(), data, data + length);
+}
+
+void flushPngData(png_structp) {
+}
+
+// libpng/zlib allocations are carved from the arena block and released all at once after the
+// encode; what does not fit comes from the heap and the block is grown to fit next time
+png_voidp arenaMalloc(png_structp png, png_alloc_size_t size) {
+    auto *buffers = static_cast<PngBuffers *>(png_get_mem_ptr(png));
+    std::size_t offset = (buffers->arenaUsed + 15) & ~static_cast<std::size_t>(15);
+    if (offset + size <= buffers->arena.size()) {
+        buffers->arenaUsed = offset + size;
+        return buffers->arena.data() + offset;
+    }
+    buffers->arenaOverflow += size + 16;
+    return std::malloc(size);
+}
+
+void arenaFree(png_structp png, png_voidp ptr) {
+    auto *buffers = static_cast<PngBuffers *>(png_get_mem_ptr(png));
+    auto *p = static_cast<unsigned char *>(ptr);
+    if (p < buffers->arena.data() || p >= buffers->arena.data() + buffers->arena.size()) {
+        std::free(ptr);
+    }
+}
+
+// Function to release the encoder and grow the arena if the encode did not fit into it
+void releasePngEncoder(png_structp &png, png_infop &info, PngBuffers &buffers) {
+    png_destroy_write_struct(&png, info ? &info : nullptr);
+    if (buffers.arenaOverflow > 0) {
+        buffers.arena.resize(buffers.arenaUsed + buffers.arenaOverflow);
+    }
+}
+
+} // namespace
+
+// Function to save a 16-bit or 8-bit PNG image with metadata
+void saveImageWithMetadata(const std::string &filename, const cv::Mat &image, const std::string &metadata, int depth, const PngOptions &options) {
+    saveImageWithMetadata(filename, image, metadata, depth, options, threadPngBuffers);
+}
+
+void saveImageWithMetadata(const std::string &filename, const cv::Mat &image, const std::string &metadata, int depth, const PngOptions &options,
+                           PngBuffers &buffers) {
+    StageTimer timer(STAGE_PNG);
+    buffers.arenaUsed = 0;
+    buffers.arenaOverflow = 0;
+    png_structp png = png_create_write_struct_2(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr, &buffers, arenaMalloc, arenaFree);
+    if (!png) {
+        return;
+    }
+
+    png_infop info = png_create_info_struct(png);
+    if (!info) {
+        releasePngEncoder(png, info, buffers);
+        return;
+    }
+
+    if (setjmp(png_jmpbuf(png))) {
+        releasePngEncoder(png, info, buffers);
+        return;
+    }
+
+    // Encode into memory, the file is written with a single call at the end
+    buffers.bytes.clear();
+    png_set_write_fn(png, &buffers.bytes, appendPngData, flushPngData);
+
+    // Compression level and filters (libpng defaults unless configured)
+    if (options.compressionLevel >= 0) {
+        png_set_compression_level(png, options.compressionLevel);
+    }
+    if (options.filters >= 0) {
+        png_set_filter(png, PNG_FILTER_TYPE_BASE, options.filters);
+    }
+
+    // Set the PNG metadata
+    png_text text;
+    text.compression = PNG_TEXT_COMPRESSION_NONE;
+    text.key = const_cast<char*>("Description");
+    text.text = const_cast<char*>(metadata.c_str());
+    text.text_length = metadata.length();
+    png_set_text(png, info, &text, 1);
+
+    // Set the image info based on depth
+    int colorType = PNG_COLOR_TYPE_GRAY;
+    if (depth == 16) {
+        png_set_IHDR(png, info, image.cols, image.rows, 16, colorType,
+                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    } else {
+        png_set_IHDR(png, info, image.cols, image.rows, 8, colorType,
+                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    }
+
+    png_write_info(png, info);
+
+    // Handle endianness for 16-bit images
+    if (depth == 16) {
+        png_set_swap(png);  // Swap endianness if the image is stored in little-endian format
+    }
+
+    // Write the image data (16-bit or 8-bit rows straight from the matrix)
+    buffers.rows.resize(image.rows);
+    for (int y = 0; y < image.rows; ++y) {
+        buffers.rows[y] = const_cast<png_bytep>(image.ptr<png_byte>(y));
+    }
+    png_write_rows(png, buffers.rows.data(), image.rows);
+
+    png_write_end(png, nullptr);
+    releasePngEncoder(png, info, buffers);
+
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (!fp) {
+        std::cerr << "Could not open file for writing: " << filename << std::endl;
+        return;
+    }
+    fwrite(buffers.bytes.data(), 1, buffers.bytes.size(), fp);
+    fclose(fp);
+    countStats(COUNTER_FILES_WRITTEN);
+    countStats(COUNTER_BYTES_WRITTEN, buffers.bytes.size());
+}
+
+void drawFrames(cv::Mat &img_lin, const Config &config, const HotspotLocation *hotspot) {
+    // Calculate the drill height based on the drill width
+    int drill_height = config.drill_width;
+    int margin = drill_height / 2;  // Calculate the margin above and below the drill
+
+    // Define the four corner points of the rectangle around the drill
+    cv::Point topLeft(config.drill_start_x, config.drill_start_y + margin);
+    cv::Point topRight(config.drill_end_x, config.drill_start_y + margin);
+    cv::Point bottomRight(config.drill_end_x, config.drill_start_y - margin);
+    cv::Point bottomLeft(config.drill_start_x, config.drill_start_y - margin);
+
+    // White in a grayscale image and in a BGR one (false-colour video frames)
+    const cv::Scalar white(255, 255, 255);
+
+    // Draw the white frame around the drill using lines connecting the corner points
+    cv::line(img_lin, topLeft, topRight, white, 1); // Top edge
+    cv::line(img_lin, topRight, bottomRight, white, 1); // Right edge
+    cv::line(img_lin, bottomRight, bottomLeft, white, 1); // Bottom edge
+    cv::line(img_lin, bottomLeft, topLeft, white, 1); // Left edge
+
+    // Draw a white frame around the hotspot (the located one in auto mode)
+    int hotspotX = hotspot && hotspot->valid ? hotspot->x : config.hotspot_x;
+    int hotspotY = hotspot && hotspot->valid ? hotspot->y : config.hotspot_y;
+    cv::rectangle(img_lin,
+                  cv::Point(hotspotX, hotspotY),
+                  cv::Point(hotspotX + config.hotspot_size, hotspotY + config.hotspot_size),
+                  white, 1);
+
+    // Draw a white frame around every named ROI
+    for (const auto &roi : config.rois) {
+        cv::rectangle(img_lin,
+                      cv::Point(roi.x, roi.y),
+                      cv::Point(roi.x + roi.width, roi.y + roi.height),
+                      white, 1);
+    }
+}
+
+// Function to compute the min/max and quantize the temperature matrix into the requested images
+void quantizeTemperatureFrame(const ThermalFrame &temperatureMatrix, int outputs, TemperatureImages &images) {
+    StageTimer timer(STAGE_QUANTIZE);
+    int rows = temperatureMatrix.height();
+    int cols = temperatureMatrix.width();
+
+    // The min-max range is only needed by the linear scaled image
+    images.minTemp = 0.0f;
+    images.maxTemp = 0.0f;
+    if (outputs & IMAGE_LIN) {
+        temperatureMinMax(temperatureMatrix, images.minTemp, images.maxTemp);
+    }
+
+    // Create OpenCV matrices only for the requested images (existing buffers are reused)
+    if (outputs & IMAGE_16BIT) images.img_16bit.create(rows, cols, CV_16UC1);  // 16-bit image for the 0-256 range
+    if (outputs & IMAGE_8BIT) images.img_8bit.create(rows, cols, CV_8UC1);     // 8-bit image for the 0-128 range
+    if (outputs & IMAGE_LIN) images.img_lin.create(rows, cols, CV_8UC1);       // 8-bit image for the min-max range
+
+    // Scale factors are hoisted out of the loop; the expressions themselves are kept as they
+    // were so the pixel values stay bit-identical (a reciprocal multiply would round differently)
+    const float range = images.maxTemp - images.minTemp;
+    const bool flat = !(range > 0.0f);  // uniform frame: the linear image is all zeros
+
+    // One pass over the rows, all requested images are produced from the row while it is in cache
+    for (int i = 0; i < rows; ++i) {
+        uint16_t *out16 = (outputs & IMAGE_16BIT) ? images.img_16bit.ptr<uint16_t>(i) : nullptr;
+        uint8_t *out8 = (outputs & IMAGE_8BIT) ? images.img_8bit.ptr<uint8_t>(i) : nullptr;
+        uint8_t *outLin = (outputs & IMAGE_LIN) ? images.img_lin.ptr<uint8_t>(i) : nullptr;
+        if (outLin && flat) {
+            std::fill(outLin, outLin + cols, 0);
+            outLin = nullptr;
+        }
+        quantizeRow(temperatureMatrix.row(i), cols, out16, out8, outLin, images.minTemp, range);
+    }
+}
+
+// Function to add the PNG writes of the requested images to a task list
+// (the images, the encoder buffers and `outputFilename` must outlive the tasks)
+void addImageWrites(TemperatureImages &images, const std::string &outputFilename, const Config &config, int outputs,
+                    PngBuffers &png16, PngBuffers &png8, PngBuffers &pngLin, std::vector<std::function<void()>> &tasks,
+                    const HotspotLocation *hotspot = nullptr) {
+    PngOptions options = pngOptionsFromConfig(config);
+
+    if (outputs & IMAGE_16BIT) {
+        // Save the 16-bit image with metadata
+        tasks.emplace_back([&images, &outputFilename, options, &png16] {
+            saveImageWithMetadata(outputFilename + "_16bit.png", images.img_16bit, "Temperature Range: 0-256", 16, options, png16);
+        });
+    }
+
+    if (outputs & IMAGE_8BIT) {
+        // Save the 8-bit image with metadata
+        tasks.emplace_back([&images, &outputFilename, options, &png8] {
+            saveImageWithMetadata(outputFilename + "_8bit.png", images.img_8bit, "Temperature Range: 0-128", 8, options, png8);
+        });
+    }
+
+    if (outputs & IMAGE_LIN) {
+        // Save the linear scaled image with metadata
+        drawFrames(images.img_lin, config, hotspot);
+        tasks.emplace_back([&images, &outputFilename, options, &pngLin] {
+            std::string minMaxText = "Min: " + std::to_string(images.minTemp) + " Max: " + std::to_string(images.maxTemp);
+            saveImageWithMetadata(outputFilename + "_lin.png", images.img_lin, minMaxText, 8, options, pngLin);
+        });
+    }
+}
+
+// Function to convert temperature matrix to images and save them
+void convertTemperatureToImage(const ThermalFrame &temperatureMatrix, const std::string &outputFilename, const Config &config, int outputs) {
+    TemperatureImages images;
+    quantizeTemperatureFrame(temperatureMatrix, outputs, images);
+
+    // The PNG encodes run concurrently on the shared task pool
+    PngBuffers png16, png8, pngLin;
+    std::vector<std::function<void()>> tasks;
+    addImageWrites(images, outputFilename, config, outputs, png16, png8, pngLin, tasks);
+    TaskPool::shared().run(tasks);
+}
+
+// Function to save the temperature matrix to a tab-delimited text file
+void saveTemperatureMatrixToFile(const ThermalFrame &temperatureMatrix, const std::string &outputFilename) {
+    std::string text;
+    saveTemperatureMatrixToFile(temperatureMatrix, outputFilename, text);
+}
+
+void saveTemperatureMatrixToFile(const ThermalFrame &temperatureMatrix, const std::string &outputFilename, std::string &text) {
+    StageTimer timer(STAGE_CSV);
+
+    // Append ".csv" to the output filename
+    std::string fullFilename = outputFilename + ".csv";
+
+    // Format the whole matrix into one buffer: at most 12 characters per value ("-273.15" plus
+    // separator; the widest raw value 65535 gives "750.83"), then write it in one go
+    const int width = temperatureMatrix.width();
+    text.resize(static_cast<size_t>(temperatureMatrix.height()) * (static_cast<size_t>(width) * 12 + 1));
+    char *out = &text[0];
+    char *const limit = out + text.size();
+
+    for (int i = 0; i < temperatureMatrix.height(); ++i) {
+        const float *row = temperatureMatrix.row(i);
+        for (int j = 0; j < width; ++j) {
+            // Same digits as std::fixed << std::setprecision(2): both round the exact value like printf("%.2f")
+            out = std::to_chars(out, limit, row[j], std::chars_format::fixed, 2).ptr;
+            *out++ = (j < width - 1) ? '\t' : '\n';  // Tab between values, new line at the end of each row
+        }
+        if (width == 0) {
+            *out++ = '\n';
+        }
+    }
+    text.resize(out - text.data());
+
+    // Written without a stream (no per-file stream buffer)
+    FILE *fp = fopen(fullFilename.c_str(), "wb");
+
+    // Check if the file opened successfully
+    if (!fp) {
+        std::cerr << "Error: Could not open file " << fullFilename << " for writing." << std::endl;
+        return;
+    }
+
+    fwrite(text.data(), 1, text.size(), fp);
+    fclose(fp);
+    countStats(COUNTER_FILES_WRITTEN);
+    countStats(COUNTER_BYTES_WRITTEN, text.size());
+}
+
+void saveTemperatureMatrixToNpy(const ThermalFrame &temperatureMatrix, const std::string &outputFilename) {
+    std::string data;
+    saveTemperatureMatrixToNpy(temperatureMatrix, outputFilename, data);
+}
+
+void saveTemperatureMatrixToNpy(const ThermalFrame &temperatureMatrix, const std::string &outputFilename, std::string &data) {
+    StageTimer timer(STAGE_NPY);
+    std::string fullFilename = outputFilename + ".npy";
+
+    // NumPy format 1.0: magic, version, header length, header dict padded to a multiple of 64 bytes
+    const int width = temperatureMatrix.width();
+    const int height = temperatureMatrix.height();
+    std::string header = "{'descr': '<f4', 'fortran_order': False, 'shape': (" +
+                         std::to_string(height) + ", " + std::to_string(width) + "), }";
+    size_t prefix = 10;  // magic (6) + version (2) + header length (2)
+    header.append(63 - (prefix + header.size()) % 64, ' ');
+    header += '\n';
+
+    data.clear();
+    data.reserve(prefix + header.size() + static_cast<size_t>(width) * height * sizeof(float));
+    data.append("\x93NUMPY\x01\x00", 8);
+    data += static_cast<char>(header.size() & 0xFF);
+    data += static_cast<char>(header.size() >> 8);
+    data += header;
+
+    // Rows without the stride padding (little-endian float32, as stored in memory on x86/ARM)
+    for (int i = 0; i < height; ++i) {
+        data.append(reinterpret_cast<const char *>(temperatureMatrix.row(i)), static_cast<size_t>(width) * sizeof(float));
+    }
+
+    FILE *fp = fopen(fullFilename.c_str(), "wb");
+    if (!fp) {
+        std::cerr << "Error: Could not open file " << fullFilename << " for writing." << std::endl;
+        return;
+    }
+    fwrite(data.data(), 1, data.size(), fp);
+    fclose(fp);
+    countStats(COUNTER_FILES_WRITTEN);
+    countStats(COUNTER_BYTES_WRITTEN, data.size());
+}
+
+// Function to convert raw image data to a YUYV422 image format and save it as JPG
+void convertImageDataToImage(RawSpan imageData, int rows, int cols, const std::string &outputFilename, int jpegQuality) {
+    thread_local cv::Mat img_bgr;
+    thread_local std::vector<uint8_t> jpeg;
+    convertImageDataToImage(imageData, rows, cols, outputFilename, jpegQuality, img_bgr, jpeg);
+}
+
+void convertImageDataToImage(RawSpan imageData, int rows, int cols, const std::string &outputFilename, int jpegQuality, cv::Mat &img_bgr,
+                             std::vector<uint8_t> &jpeg) {
+    StageTimer timer(STAGE_JPG);
+
+    // The upper half already holds packed YUYV422 bytes (Y0 U0 Y1 V0 ...), so it is wrapped
+    // as a CV_8UC2 matrix header without copying: 2 bytes per pixel, one 16-bit word each
+    cv::Mat img_yuyv(rows / 2, cols, CV_8UC2, const_cast<uint16_t *>(imageData.data), static_cast<size_t>(cols) * sizeof(uint16_t));
+
+    // Convert the YUYV422 image to BGR (color) format for saving as JPG
+    cv::cvtColor(img_yuyv, img_bgr, cv::COLOR_YUV2BGR_YUYV);
+
+    // Encode and save the image as JPG
+    if (!cv::imencode(".jpg", img_bgr, jpeg, {cv::IMWRITE_JPEG_QUALITY, jpegQuality})) {
+        std::cerr << "Could not encode JPG image: " << outputFilename << ".jpg" << std::endl;
+        return;
+    }
+
+    FILE *fp = fopen((outputFilename + ".jpg").c_str(), "wb");
+    if (!fp) {
+        std::cerr << "Could not open file for writing: " << outputFilename << ".jpg" << std::endl;
+        return;
+    }
+    fwrite(jpeg.data(), 1, jpeg.size(), fp);
+    fclose(fp);
+    countStats(COUNTER_FILES_WRITTEN);
+    countStats(COUNTER_BYTES_WRITTEN, jpeg.size());
+}
+
+/* HOT SPOT */
+
+float calculateHotspotAverage(const ThermalFrame &temperatureMatrix, const Config &config) {
+    size_t startX = config.hotspot_x;
+    size_t startY = config.hotspot_y;
+    size_t size = config.hotspot_size;
+    size_t height = temperatureMatrix.height();
+    size_t width = temperatureMatrix.width();
+
+    float sum = 0.0;
+    int count = 0;
+
+    // Sum the temperatures in the square region
+    for (size_t i = startY; i < startY + size && i < height; ++i) {
+        const float *row = temperatureMatrix.row(static_cast<int>(i));
+        for (size_t j = startX; j < startX + size && j < width; ++j) {
+            sum += row[j];
+            ++count;
+        }
+    }
+
+    if (count == 0) return 0.0f;  // Avoid division by zero
+
+    return sum / count;  // Return the average temperature
+}
+
+float calculateHotspotAverage(RawSpan temperatureData, int rows, int cols, const Config &config) {
+    return calculateHotspotAverage(temperatureData, rows, cols, config.hotspot_x, config.hotspot_y, config.hotspot_size);
+}
+
+float calculateHotspotAverage(RawSpan temperatureData, int rows, int cols, int x, int y, int size) {
+    size_t startX = x;
+    size_t startY = y;
+    size_t height = rows / 2;
+    size_t width = cols;
+
+    float sum = 0.0;
+    int count = 0;
+
+    // Convert and sum only the temperatures in the square region (same order as above)
+    for (size_t i = startY; i < startY + size && i < height; ++i) {
+        const uint16_t *row = temperatureData.data + i * width;
+        for (size_t j = startX; j < startX + size && j < width; ++j) {
+            sum += static_cast<float>(row[j]) / 64.0f - 273.15f;
+            ++count;
+        }
+    }
+
+    if (count == 0) return 0.0f;  // Avoid division by zero
+
+    return sum / count;  // Return the average temperature
+}
+
+int classifyHotspotRaw(RawSpan temperatureData, int rows, int cols, const Config &config) {
+    // The square clipped to the frame, as in calculateHotspotAverage (which finds no pixels at all
+    // for a negative corner or size)
+    int height = rows / 2;
+    int x0 = config.hotspot_x;
+    int y0 = config.hotspot_y;
+    int x1 = std::min(config.hotspot_x + config.hotspot_size, cols);
+    int y1 = std::min(config.hotspot_y + config.hotspot_size, height);
+    if (x0 < 0 || y0 < 0 || config.hotspot_size <= 0 || x0 >= x1 || y0 >= y1) {
+        return 0.0f >= config.hotspot_temp_threshold ? 1 : 0;  // empty square: the float path's mean is 0
+    }
+
+    uint64_t sum = 0;
+    for (int y = y0; y < y1; ++y) {
+        sum += rawSum(temperatureData.data + static_cast<size_t>(y) * cols + x0, static_cast<size_t>(x1 - x0));
+    }
+
+    // The bound of a clipped square is computed here (a few flops)
+    int count = (x1 - x0) * (y1 - y0);
+    RawSumBound bound = count == config.hotspot_raw_bound.count ? config.hotspot_raw_bound
+                                                                 : rawSumBound(config.hotspot_temp_threshold, count);
+    int64_t rawTotal = static_cast<int64_t>(sum);
+    if (rawTotal < bound.below) return 0;
+    if (rawTotal >= bound.above) return 1;
+    return calculateHotspotAverage(temperatureData, rows, cols, config) >= config.hotspot_temp_threshold ? 1 : 0;
+}
+
+/* DRILL */
+
+// Function to clip the drill band (the region outlined by drawFrames) to the frame
+bool drillBand(const Config &config, int width, int height, int &x0, int &x1, int &y0, int &y1) {
+    int margin = config.drill_width / 2;  // Same margin above and below the drill as in drawFrames
+    x0 = std::max(std::min(config.drill_start_x, config.drill_end_x), 0);
+    x1 = std::min(std::max(config.drill_start_x, config.drill_end_x), width - 1);
+    y0 = std::max(config.drill_start_y - margin, 0);
+    y1 = std::min(config.drill_start_y + margin, height - 1);
+    return x0 <= x1 && y0 <= y1;
+}
+
+float calculateMaxTemperatureOnDrillLine(const ThermalFrame &temperatureMatrix, const Config &config) {
+    float maxTemp = std::numeric_limits<float>::lowest();
+    int x0, x1, y0, y1;
+    if (!drillBand(config, temperatureMatrix.width(), temperatureMatrix.height(), x0, x1, y0, y1)) {
+        return maxTemp;
+    }
+
+    for (int y = y0; y <= y1; ++y) {
+        const float *row = temperatureMatrix.row(y);
+        for (int x = x0; x <= x1; ++x) {
+            maxTemp = std::max(maxTemp, row[x]);
+        }
+    }
+    return maxTemp;
+}
+
+float calculateMaxTemperatureOnDrillLine(RawSpan temperatureData, int rows, int cols, const Config &config) {
+    int x0, x1, y0, y1;
+    if (!drillBand(config, cols, rows / 2, x0, x1, y0, y1)) {
+        return std::numeric_limits<float>::lowest();
+    }
+
+    // The conversion is monotonic, so the hottest raw word gives the maximum temperature
+    uint16_t maxRaw = 0;
+    for (int y = y0; y <= y1; ++y) {
+        const uint16_t *row = temperatureData.data + static_cast<size_t>(y) * cols;
+        maxRaw = std::max(maxRaw, *std::max_element(row + x0, row + x1 + 1));
+    }
+    return static_cast<float>(maxRaw) / 64.0f - 273.15f;
+}
+
+// Function to remove the file extension from a filename
+std::string removeFileExtension(const std::string &filename) {
+    size_t lastDot = filename.find_last_of(".");
+    if (lastDot == std::string::npos) return filename;
+    return filename.substr(0, lastDot);
+}
+
+// Function to calculate the hot spot average of the fixed square, or of the located spot in auto
+// mode (with a one-frame tracker when none is given)
+float hotspotAverage(RawSpan temperatureData, int rows, int cols, const Config &config, HotspotTracker *tracker, HotspotLocation *location) {
+    if (!config.hotspot_auto) {
+        return calculateHotspotAverage(temperatureData, rows, cols, config);
+    }
+    HotspotTracker frameTracker;
+    HotspotLocation found = (tracker ? *tracker : frameTracker).locate(temperatureData, rows, cols, config);
+    if (location) *location = found;
+    return found.mean;
+}
+
+FrameStats calculateFrameStats(RawSpan temperatureData, int rows, int cols, const Config &config, HotspotTracker *tracker) {
+    StageTimer timer(STAGE_FRAME_STATS);
+    FrameStats stats;
+    stats.hotspotMean = hotspotAverage(temperatureData, rows, cols, config, tracker, nullptr);
+    stats.drillMax = calculateMaxTemperatureOnDrillLine(temperatureData, rows, cols, config);
+
+    // The conversion is monotonic: min/max of the raw words give the frame min/max
+    auto range = std::minmax_element(temperatureData.begin(), temperatureData.end());
+    if (range.first != temperatureData.end()) {
+        stats.minTemp = static_cast<float>(*range.first) / 64.0f - 273.15f;
+        stats.maxTemp = static_cast<float>(*range.second) / 64.0f - 273.15f;
+    }
+
+    stats.valid = true;
+    return stats;
+}
+
+FrameStats calculateFrameStats(const std::string &filename, const Config &config, HotspotTracker *tracker) {
+    Tc0File file;
+    if (!file.open(filename)) {
+        return FrameStats();
+    }
+    return calculateFrameStats(file.temperatureData(), file.rows(), file.cols(), config, tracker);
+}
+
+int classifyFrameStats(const FrameStats &stats, const Config &config) {
+    if (!stats.valid) return -1;
+    return stats.hotspotMean >= config.hotspot_temp_threshold ? 1 : 0;
+}
+
+bool parseFrameOutputs(const std::string &list, int &outputs) {
+    static const std::map<std::string, int> names = {
+        {"16bit", IMAGE_16BIT}, {"8bit", IMAGE_8BIT}, {"lin", IMAGE_LIN},
+        {"csv", OUTPUT_CSV}, {"jpg", OUTPUT_JPG}, {"npy", OUTPUT_NPY}, {"all", OUTPUT_ALL}, {"none", 0}};
+
+    if (list.empty()) {
+        outputs = OUTPUT_ALL;
+        return true;
+    }
+
+    int result = 0;
+    std::istringstream iss(list);
+    std::string name;
+    while (std::getline(iss, name, ',')) {
+        auto it = names.find(name);
+        if (it == names.end()) {
+            std::cerr << "Error: Unknown output type: " << name << std::endl;
+            return false;
+        }
+        result |= it->second;
+    }
+
+    outputs = result;
+    return true;
+}
+
+int classifyFrame(const std::string &filename, const Config &config) {
+    Tc0File file;
+    if (!file.open(filename)) {
+        return -1;
+    }
+
+    // Only the hot spot pixels of the temperature half are read (summed as integers)
+    if (!config.hotspot_auto) {
+        return classifyHotspotRaw(file.temperatureData(), file.rows(), file.cols(), config);
+    }
+    float averageTemp = hotspotAverage(file.temperatureData(), file.rows(), file.cols(), config, nullptr, nullptr);
+
+    return averageTemp >= config.hotspot_temp_threshold ? 1 : 0;
+}
+
+int processFrame(const std::string &inputFilename, const Config &config, int outputs, std::vector<RoiResult> *rois, FramePool *pool,
+                 float *hotspotMean, HotspotLocation *hotspot) {
+    // All buffers of the frame come from the pool (sized once per frame size)
+    thread_local FramePool threadPool;
+    FramePool &buffers = pool ? *pool : threadPool;
+
+    // Map the binary file; image and temperature halves are views into it
+    if (!buffers.file.open(inputFilename)) {
+        return -1;
+    }
+    return processOpenFrame(inputFilename, config, outputs, rois, buffers, hotspotMean, hotspot);
+}
+
+int processOpenFrame(const std::string &inputFilename, const Config &config, int outputs, std::vector<RoiResult> *rois, FramePool &buffers,
+                     float *hotspotMean, HotspotLocation *hotspot) {
+    bool wantRois = rois && !config.rois.empty();
+    Tc0File &file = buffers.file;
+
+    // Auto mode: locate the hot spot first (from the raw words), the _lin.png frame follows it
+    HotspotLocation location;
+    if (config.hotspot_auto) {
+        StageTimer timer(STAGE_FRAME_STATS);
+        location = buffers.tracker.locate(file.temperatureData(), file.rows(), file.cols(), config);
+        if (hotspot) *hotspot = location;
+    }
+
+    // Classify only: no output files, skip the whole image path
+    // (only the hot spot pixels of the temperature half are read; as integers when the mean is not wanted)
+    if (outputs == 0 && !wantRois) {
+        StageTimer timer(STAGE_FRAME_STATS);
+        if (!hotspotMean && !config.hotspot_auto) {
+            int verdict = classifyHotspotRaw(file.temperatureData(), file.rows(), file.cols(), config);
+            file.close();
+            return verdict;
+        }
+        float averageTemp = config.hotspot_auto ? location.mean
+                                                : calculateHotspotAverage(file.temperatureData(), file.rows(), file.cols(), config);
+        file.close();
+        if (hotspotMean) *hotspotMean = averageTemp;
+        return averageTemp >= config.hotspot_temp_threshold ? 1 : 0;
+    }
+
+    // Output files go next to the frame (frames of an archive: next to the archive)
+    std::string baseFilename = removeFileExtension(memberFilePath(inputFilename));
+    buffers.prepare(file.rows(), file.cols());
+
+    // Convert the temperature data to a temperature matrix in Celsius
+    ThermalFrame &temperatureMatrix = buffers.temperature;
+    convertToTemperature(file.temperatureData(), file.rows(), file.cols(), temperatureMatrix);
+
+    // Quantize the requested images
+    if (outputs & IMAGE_ALL) {
+        quantizeTemperatureFrame(temperatureMatrix, outputs & IMAGE_ALL, buffers.images);
+    }
+
+    // All output files of the frame are encoded and written concurrently on the task pool
+    std::vector<std::function<void()>> &tasks = buffers.tasks;
+    tasks.clear();
+
+    // Convert the temperature matrix to an image and save as PNG
+    if (outputs & IMAGE_ALL) {
+        addImageWrites(buffers.images, baseFilename, config, outputs & IMAGE_ALL, buffers.png16, buffers.png8, buffers.pngLin, tasks,
+                       config.hotspot_auto ? &location : nullptr);
+    }
+
+    // Save the temperature matrix to a file named "temperature_data.csv"
+    if (outputs & OUTPUT_CSV) {
+        tasks.emplace_back([&] { saveTemperatureMatrixToFile(temperatureMatrix, baseFilename, buffers.csv); });
+    }
+
+    // Save the temperature matrix as a NumPy array (float32)
+    if (outputs & OUTPUT_NPY) {
+        tasks.emplace_back([&] { saveTemperatureMatrixToNpy(temperatureMatrix, baseFilename, buffers.npy); });
+    }
+
+    // Convert the raw image data to a YUYV422 image and save as JPG
+    if (outputs & OUTPUT_JPG) {
+        tasks.emplace_back([&] {
+            convertImageDataToImage(file.imageData(), file.rows(), file.cols(), baseFilename, config.jpg_quality, buffers.bgr, buffers.jpeg);
+        });
+    }
+
+    TaskPool::shared().run(tasks);
+    tasks.clear();
+
+    // Evaluate the named ROIs on the same temperature matrix
+    if (wantRois) {
+        *rois = evaluateRois(temperatureMatrix, config, buffers.table);
+    }
+
+    // Calculate the average temperature in the hot spot
+    float averageTemp = config.hotspot_auto ? location.mean : calculateHotspotAverage(temperatureMatrix, config);
+    if (hotspotMean) *hotspotMean = averageTemp;
+
+    file.close();
+    buffers.recycle();
+
+    return averageTemp >= config.hotspot_temp_threshold ? 1 : 0;
+}
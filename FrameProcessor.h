@@ -0,0 +1,166 @@
+#ifndef FRAMEPROCESSOR_H
+#define FRAMEPROCESSOR_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+#include "ConfigReader.h"
+#include "Tc0File.h"
+#include "ThermalFrame.h"
+#include "RoiEngine.h"
+#include "HotspotTracker.h"
+
+// Wspólna biblioteka przetwarzania pojedynczej ramki .tc0 (mtpFrame i mtpSeries)
+
+class FramePool;
+
+// Function to load raw data from the file and split it into image and temperature matrices
+bool loadDataFromFile(const std::string &filename, std::vector<uint16_t> &imageData, std::vector<uint16_t> &temperatureData, int &rows, int &cols);
+
+// Function to convert raw temperature data to a temperature matrix in Celsius
+// (the in-place overload reuses the frame's buffer)
+ThermalFrame convertToTemperature(RawSpan temperatureData, int rows, int cols);
+void convertToTemperature(RawSpan temperatureData, int rows, int cols, ThermalFrame &temperatureMatrix);
+
+// PNG encoder settings (png_compression / png_filter in config.txt); -1 keeps the libpng default
+struct PngOptions {
+    int compressionLevel = -1;  // zlib level 0-9
+    int filters = -1;           // PNG_FILTER_* mask
+};
+
+// Function to map the png_compression/png_filter config values to encoder options
+PngOptions pngOptionsFromConfig(const Config &config);
+
+// Reusable state of one PNG encode: the encoded bytes, the row pointers and a block the
+// libpng/zlib working memory is carved from (grown once when an encode does not fit)
+struct PngBuffers {
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t *> rows;
+    std::vector<unsigned char> arena;
+    std::size_t arenaUsed = 0;
+    std::size_t arenaOverflow = 0;  // bytes the last encode had to take from the heap
+};
+
+// Function to save a 16-bit or 8-bit PNG image with metadata
+// (the overload without buffers uses a per-thread set)
+void saveImageWithMetadata(const std::string &filename, const cv::Mat &image, const std::string &metadata, int depth, const PngOptions &options = PngOptions());
+void saveImageWithMetadata(const std::string &filename, const cv::Mat &image, const std::string &metadata, int depth, const PngOptions &options, PngBuffers &buffers);
+
+// Function to draw the drill and hotspot frames onto an image (grayscale or BGR)
+// (with `hotspot` set the frame follows the located hot spot instead of hotspot_x/hotspot_y)
+void drawFrames(cv::Mat &img_lin, const Config &config, const HotspotLocation *hotspot = nullptr);
+
+// Files written for a frame (bit flags, combine with |)
+enum ImageOutput {
+    IMAGE_16BIT = 1,  // _16bit.png: 0-256 C scaled to 16 bits
+    IMAGE_8BIT = 2,   // _8bit.png: 0-128 C scaled to 8 bits
+    IMAGE_LIN = 4,    // _lin.png: min-max range scaled to 8 bits, with drill/hotspot frames
+    IMAGE_ALL = IMAGE_16BIT | IMAGE_8BIT | IMAGE_LIN,
+    OUTPUT_CSV = 8,   // .csv: temperature matrix
+    OUTPUT_JPG = 16,  // .jpg: visible image
+    OUTPUT_ALL = IMAGE_ALL | OUTPUT_CSV | OUTPUT_JPG,
+    OUTPUT_NPY = 32   // .npy: temperature matrix as NumPy float32 array (not part of "all")
+};
+
+// Quantized images of one frame; only the requested ones are filled in
+struct TemperatureImages {
+    cv::Mat img_16bit;
+    cv::Mat img_8bit;
+    cv::Mat img_lin;
+    float minTemp = 0.0f;  // only computed when IMAGE_LIN is requested
+    float maxTemp = 0.0f;
+};
+
+// Function to compute the min/max and quantize the temperature matrix into the requested images
+void quantizeTemperatureFrame(const ThermalFrame &temperatureMatrix, int outputs, TemperatureImages &images);
+
+// Function to convert temperature matrix to images and save them
+void convertTemperatureToImage(const ThermalFrame &temperatureMatrix, const std::string &outputFilename, const Config &config, int outputs = IMAGE_ALL);
+
+// Function to save the temperature matrix to a tab-delimited text file
+// (`text` is the formatting buffer, reused when given)
+void saveTemperatureMatrixToFile(const ThermalFrame &temperatureMatrix, const std::string &outputFilename);
+void saveTemperatureMatrixToFile(const ThermalFrame &temperatureMatrix, const std::string &outputFilename, std::string &text);
+
+// Function to save the temperature matrix as a NumPy .npy file (float32, shape rows x cols),
+// which numpy.load(..., mmap_mode='r') can map directly
+void saveTemperatureMatrixToNpy(const ThermalFrame &temperatureMatrix, const std::string &outputFilename);
+void saveTemperatureMatrixToNpy(const ThermalFrame &temperatureMatrix, const std::string &outputFilename, std::string &data);
+
+// Function to convert raw image data (packed YUYV422, wrapped without copying) to BGR and save it as JPG
+// (the overload without buffers keeps the BGR matrix and the encoded bytes per thread)
+void convertImageDataToImage(RawSpan imageData, int rows, int cols, const std::string &outputFilename, int jpegQuality = 95);
+void convertImageDataToImage(RawSpan imageData, int rows, int cols, const std::string &outputFilename, int jpegQuality, cv::Mat &img_bgr, std::vector<uint8_t> &jpeg);
+
+// Function to calculate the average temperature in the hot spot
+float calculateHotspotAverage(const ThermalFrame &temperatureMatrix, const Config &config);
+
+// Function to calculate the hot spot average straight from the raw temperature half,
+// converting only the pixels of the region (same result as the ThermalFrame version)
+float calculateHotspotAverage(RawSpan temperatureData, int rows, int cols, const Config &config);
+
+// Function to calculate the average temperature of any size x size square from the raw temperature half
+float calculateHotspotAverage(RawSpan temperatureData, int rows, int cols, int x, int y, int size);
+
+// Function to classify the fixed hot spot from the raw words of its square only: their integer
+// sum is compared with the raw sum bound of hotspot_temp_threshold (config.hotspot_raw_bound).
+// A sum within the rounding margin of the bound is decided by calculateHotspotAverage, so the
+// verdict is always the one of the float path. Returns 1 at or above the threshold, 0 below
+int classifyHotspotRaw(RawSpan temperatureData, int rows, int cols, const Config &config);
+
+// Function to calculate the maximum temperature in the drill band: drill_start_x..drill_end_x,
+// drill_width rows centred on drill_start_y (the region outlined by drawFrames).
+// Returns numeric_limits<float>::lowest() if the band lies outside the frame
+float calculateMaxTemperatureOnDrillLine(const ThermalFrame &temperatureMatrix, const Config &config);
+float calculateMaxTemperatureOnDrillLine(RawSpan temperatureData, int rows, int cols, const Config &config);
+
+// Function to remove the file extension from a filename
+std::string removeFileExtension(const std::string &filename);
+
+// Per-frame statistics used by mtpSeries (and cached in its index)
+struct FrameStats {
+    float hotspotMean = 0.0f;  // calculateHotspotAverage
+    float minTemp = 0.0f;      // frame minimum
+    float maxTemp = 0.0f;      // frame maximum
+    float drillMax = 0.0f;     // calculateMaxTemperatureOnDrillLine
+    bool valid = false;        // false if the frame could not be read
+};
+
+// Function to compute the statistics of a frame from its raw temperature half
+// (only the temperature words are read, nothing is converted except the results).
+// With hotspot_mode = auto the hot spot mean is that of the spot located in the whole frame;
+// `tracker` only lends its scratch buffers (without one a temporary tracker is used)
+FrameStats calculateFrameStats(RawSpan temperatureData, int rows, int cols, const Config &config, HotspotTracker *tracker = nullptr);
+
+// Function to compute the statistics of a frame file; stats.valid is false on error
+FrameStats calculateFrameStats(const std::string &filename, const Config &config, HotspotTracker *tracker = nullptr);
+
+// Function to classify a frame from its statistics: 1 above the threshold, 0 below, -1 invalid
+int classifyFrameStats(const FrameStats &stats, const Config &config);
+
+// Function to parse a comma separated list of outputs ("16bit,8bit,lin,csv,jpg,npy", "all", "none")
+// into OUTPUT_* / IMAGE_* flags; an empty list means all outputs
+bool parseFrameOutputs(const std::string &list, int &outputs);
+
+// Function to classify a single frame without writing any output files
+// Returns 1 if the hot spot is above the threshold, 0 if below, -1 on error
+int classifyFrame(const std::string &filename, const Config &config);
+
+// Function to run the mtpFrame pipeline on a single file, writing the requested output files
+// (outputs == 0 only classifies). If `rois` is given, the named ROIs of the config are evaluated too.
+// Every buffer comes from `pool` (a per-thread pool when none is given), so a run over frames of
+// one size allocates them only once. The hot spot average is stored in `hotspotMean` if given.
+// With hotspot_mode = auto the spot is located in the whole frame, with the pool's tracker as
+// scratch space, and its location is stored in `hotspot` if given.
+// Returns 1 if the hot spot is above the threshold, 0 if below, -1 on error
+int processFrame(const std::string &inputFilename, const Config &config, int outputs = OUTPUT_ALL, std::vector<RoiResult> *rois = nullptr,
+                 FramePool *pool = nullptr, float *hotspotMean = nullptr, HotspotLocation *hotspot = nullptr);
+
+// Function to run the rest of the pipeline on a frame already opened in `pool.file` (by a
+// prefetching stage, see FramePipeline.h); the file is closed when it returns
+int processOpenFrame(const std::string &inputFilename, const Config &config, int outputs, std::vector<RoiResult> *rois, FramePool &pool,
+                     float *hotspotMean = nullptr, HotspotLocation *hotspot = nullptr);
+
+#endif // FRAMEPROCESSOR_H
@@ -0,0 +1,236 @@
+#include "HotspotTracker.h"
+#include "FrameProcessor.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HOTSPOTTRACKER_X86 1
+#endif
+
+namespace {
+
+uint16_t rawMaxScalar(const uint16_t *src, std::size_t n) {
+    uint16_t maxValue = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        maxValue = src[i] > maxValue ? src[i] : maxValue;
+    }
+    return maxValue;
+}
+
+std::size_t rawFindScalar(const uint16_t *src, std::size_t n, uint16_t value) {
+    std::size_t i = 0;
+    while (i < n && src[i] != value) ++i;
+    return i;
+}
+
+#ifdef HOTSPOTTRACKER_X86
+__attribute__((target("avx2")))
+uint16_t rawMaxAvx2(const uint16_t *src, std::size_t n) {
+    __m256i best = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        best = _mm256_max_epu16(best, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)));
+    }
+    alignas(32) uint16_t lanes[16];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), best);
+    return std::max(rawMaxScalar(lanes, 16), rawMaxScalar(src + i, n - i));
+}
+
+// SSE2 has only a signed 16-bit max: flipping the sign bit maps the unsigned order onto it
+__attribute__((target("sse2")))
+uint16_t rawMaxSse2(const uint16_t *src, std::size_t n) {
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+    __m128i best = bias;  // raw 0
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        best = _mm_max_epi16(best, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), bias));
+    }
+    alignas(16) uint16_t lanes[8];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), _mm_xor_si128(best, bias));
+    return std::max(rawMaxScalar(lanes, 8), rawMaxScalar(src + i, n - i));
+}
+
+__attribute__((target("sse2")))
+std::size_t rawFindSse2(const uint16_t *src, std::size_t n, uint16_t value) {
+    const __m128i target = _mm_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), target));
+        if (mask != 0) {
+            return i + __builtin_ctz(static_cast<unsigned>(mask)) / 2;
+        }
+    }
+    return i + rawFindScalar(src + i, n - i, value);
+}
+#endif
+
+// Function to tell whether a raw word is at or above the temperature threshold
+inline bool isHot(uint16_t raw, float threshold) {
+    return static_cast<float>(raw) / 64.0f - 273.15f >= threshold;
+}
+
+} // namespace
+
+std::size_t rawArgMax(const uint16_t *src, std::size_t n, uint16_t &maxValue) {
+    // Maximum first, then its first position (the second pass stops early and the data is in cache)
+#ifdef HOTSPOTTRACKER_X86
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    maxValue = hasAvx2 ? rawMaxAvx2(src, n) : rawMaxSse2(src, n);
+    return n == 0 ? 0 : rawFindSse2(src, n, maxValue);
+#else
+    maxValue = rawMaxScalar(src, n);
+    return n == 0 ? 0 : rawFindScalar(src, n, maxValue);
+#endif
+}
+
+void HotspotTracker::searchWindow(RawSpan temperatureData, int cols, int x0, int y0, int x1, int y1, int filter, int &peakX, int &peakY,
+                                  uint64_t &score) {
+    peakX = x0;
+    peakY = y0;
+    score = 0;
+    bool first = true;
+
+    // Hottest pixel: vectorized argmax of every window row
+    if (filter <= 1) {
+        for (int y = y0; y < y1; ++y) {
+            uint16_t value;
+            std::size_t x = rawArgMax(temperatureData.data + static_cast<std::size_t>(y) * cols + x0, static_cast<std::size_t>(x1 - x0), value);
+            if (first || value > score) {
+                score = value;
+                peakX = x0 + static_cast<int>(x);
+                peakY = y;
+                first = false;
+            }
+        }
+        return;
+    }
+
+    // Hottest filter x filter box: column sums over `filter` rows slide down the window, a
+    // running sum of `filter` columns slides along each box row
+    const int width = x1 - x0;
+    columnSums_.assign(static_cast<std::size_t>(width), 0);
+    for (int y = y0; y < y0 + filter; ++y) {
+        const uint16_t *row = temperatureData.data + static_cast<std::size_t>(y) * cols + x0;
+        for (int x = 0; x < width; ++x) {
+            columnSums_[x] += row[x];
+        }
+    }
+    for (int by = y0; by + filter <= y1; ++by) {
+        uint64_t sum = 0;
+        for (int x = 0; x < filter; ++x) {
+            sum += columnSums_[x];
+        }
+        for (int bx = 0; bx + filter <= width; ++bx) {
+            if (bx > 0) {
+                sum += columnSums_[bx + filter - 1];
+                sum -= columnSums_[bx - 1];
+            }
+            if (first || sum > score) {
+                score = sum;
+                peakX = x0 + bx + filter / 2;
+                peakY = by + filter / 2;
+                first = false;
+            }
+        }
+        if (by + filter < y1) {
+            const uint16_t *leaving = temperatureData.data + static_cast<std::size_t>(by) * cols + x0;
+            const uint16_t *entering = temperatureData.data + static_cast<std::size_t>(by + filter) * cols + x0;
+            for (int x = 0; x < width; ++x) {
+                columnSums_[x] += entering[x] - leaving[x];
+            }
+        }
+    }
+}
+
+int HotspotTracker::connectedArea(RawSpan temperatureData, int cols, int x0, int y0, int x1, int y1, int peakX, int peakY, float threshold) {
+    if (!isHot(temperatureData.data[static_cast<std::size_t>(peakY) * cols + peakX], threshold)) {
+        return 0;
+    }
+
+    // Flood fill (4-connected) from the peak, bounded by the window
+    const int width = x1 - x0;
+    visited_.assign(static_cast<std::size_t>(width) * (y1 - y0), 0);
+    stack_.clear();
+    stack_.push_back((peakY - y0) * width + (peakX - x0));
+    visited_[stack_.back()] = 1;
+    int area = 0;
+    while (!stack_.empty()) {
+        int p = stack_.back();
+        stack_.pop_back();
+        ++area;
+        int x = p % width;
+        int y = p / width;
+        const int neighbours[4][2] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+        for (const auto &n : neighbours) {
+            if (n[0] < 0 || n[0] >= width || n[1] < 0 || n[1] >= y1 - y0) continue;
+            int q = n[1] * width + n[0];
+            if (visited_[q]) continue;
+            visited_[q] = 1;
+            if (isHot(temperatureData.data[static_cast<std::size_t>(y0 + n[1]) * cols + x0 + n[0]], threshold)) {
+                stack_.push_back(q);
+            }
+        }
+    }
+    return area;
+}
+
+HotspotLocation HotspotTracker::locate(RawSpan temperatureData, int rows, int cols, const Config &config) {
+    HotspotLocation location;
+    const int width = cols;
+    const int height = rows / 2;
+    if (width <= 0 || height <= 0 || temperatureData.size < static_cast<std::size_t>(width) * height) {
+        return location;
+    }
+
+    // The hottest pixel or box of the whole frame
+    const float threshold = config.hotspot_temp_threshold;
+    int peakX, peakY;
+    uint64_t score;
+    int filter = std::min({config.hotspot_filter, width, height});
+    searchWindow(temperatureData, cols, 0, 0, width, height, filter, peakX, peakY, score);
+
+    // The hot spot square centred on the peak, moved inside the frame
+    location.size = config.hotspot_size;
+    location.x = std::max(std::min(peakX - location.size / 2, width - location.size), 0);
+    location.y = std::max(std::min(peakY - location.size / 2, height - location.size), 0);
+    location.mean = calculateHotspotAverage(temperatureData, rows, cols, location.x, location.y, location.size);
+
+    // Hottest pixel of the square (the peak itself unless a box filter was used)
+    uint16_t peakRaw = 0;
+    location.peakX = peakX;
+    location.peakY = peakY;
+    int squareX1 = std::min(location.x + location.size, width);
+    int squareY1 = std::min(location.y + location.size, height);
+    for (int y = location.y; y < squareY1; ++y) {
+        uint16_t value;
+        std::size_t x = rawArgMax(temperatureData.data + static_cast<std::size_t>(y) * cols + location.x,
+                                  static_cast<std::size_t>(squareX1 - location.x), value);
+        if (value > peakRaw) {
+            peakRaw = value;
+            location.peakX = location.x + static_cast<int>(x);
+            location.peakY = y;
+        }
+    }
+    location.peak = static_cast<float>(peakRaw) / 64.0f - 273.15f;
+
+    // Hot area around the peak: within hotspot_search pixels of it (0 = the whole frame)
+    int x0 = 0, y0 = 0, x1 = width, y1 = height;
+    if (config.hotspot_search > 0) {
+        x0 = std::max(location.peakX - config.hotspot_search, 0);
+        y0 = std::max(location.peakY - config.hotspot_search, 0);
+        x1 = std::min(location.peakX + config.hotspot_search + 1, width);
+        y1 = std::min(location.peakY + config.hotspot_search + 1, height);
+    }
+    location.area = connectedArea(temperatureData, cols, x0, y0, x1, y1, location.peakX, location.peakY, threshold);
+    location.valid = true;
+    return location;
+}
+
+std::string formatHotspotLocation(const HotspotLocation &location) {
+    char buffer[96];
+    std::snprintf(buffer, sizeof(buffer), "hotspot:%d,%d,%d:%.2f:%.2f:%d", location.x, location.y, location.size, location.mean, location.peak,
+                  location.area);
+    return buffer;
+}
@@ -0,0 +1,56 @@
+#ifndef HOTSPOTTRACKER_H
+#define HOTSPOTTRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ConfigReader.h"
+#include "Tc0File.h"
+
+// Hot spot found in a frame (hotspot_mode = auto): the hotspot_size square centred on the
+// hottest pixel (or on the hottest hotspot_filter box), moved inside the frame
+struct HotspotLocation {
+    int x = 0;          // top left corner of the square
+    int y = 0;
+    int size = 0;       // side of the square
+    int peakX = 0;      // hottest pixel of the square
+    int peakY = 0;
+    float mean = 0.0f;  // average of the square (same sum as calculateHotspotAverage)
+    float peak = 0.0f;  // hottest temperature in the square
+    int area = 0;       // pixels >= hotspot_temp_threshold 4-connected to the peak, within hotspot_search of it
+    bool valid = false;
+};
+
+// Function to find the first maximum of n raw words; returns its index and sets maxValue (SSE2/AVX2)
+std::size_t rawArgMax(const uint16_t *src, std::size_t n, uint16_t &maxValue);
+
+// Locates the hot spot frame by frame: the hottest pixel (or hotspot_filter box) of the whole
+// frame, the first one in row order on a tie. Every frame is searched as a whole, so the result
+// depends on that frame only (not on the frames a tracker saw before, or on which thread or
+// shard ran it); a window around the previous peak cannot be proven to hold the frame's
+// hottest spot without reading the rest of the frame anyway.
+// A tracker only holds scratch buffers, which are kept so it allocates only when the frame grows.
+class HotspotTracker {
+public:
+    // Function to locate the hot spot in the raw temperature half of a rows x cols .tc0 frame
+    HotspotLocation locate(RawSpan temperatureData, int rows, int cols, const Config &config);
+
+private:
+    // Function to find the hottest pixel (filter <= 1) or box of the window [x0, x1) x [y0, y1)
+    void searchWindow(RawSpan temperatureData, int cols, int x0, int y0, int x1, int y1, int filter, int &peakX, int &peakY,
+                      uint64_t &score);
+
+    // Function to count the hot pixels connected to the peak, within [x0, x1) x [y0, y1)
+    int connectedArea(RawSpan temperatureData, int cols, int x0, int y0, int x1, int y1, int peakX, int peakY, float threshold);
+
+    std::vector<uint32_t> columnSums_;  // box filter: running column sums of one window row
+    std::vector<uint8_t> visited_;      // connected area: pixels of the window already reached
+    std::vector<int> stack_;
+};
+
+// Function to format a location as "hotspot:x,y,size:mean:peak:area" (like formatRoiResults)
+std::string formatHotspotLocation(const HotspotLocation &location);
+
+#endif // HOTSPOTTRACKER_H
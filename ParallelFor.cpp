@@ -0,0 +1,178 @@
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// One contiguous slice of the index range owned by a worker
+struct Slice {
+    std::atomic<std::size_t> next{0};
+    std::size_t end = 0;
+};
+
+// Function to claim the next chunk of a slice; returns false when the slice is exhausted
+bool claimChunk(Slice &slice, std::size_t chunkSize, std::size_t &begin, std::size_t &end) {
+    std::size_t start = slice.next.fetch_add(chunkSize, std::memory_order_relaxed);
+    if (start >= slice.end) return false;
+    begin = start;
+    end = std::min(start + chunkSize, slice.end);
+    return true;
+}
+
+} // namespace
+
+int hardwareJobs() {
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : static_cast<int>(n);
+}
+
+int clampJobs(int jobs) {
+    int hardware = hardwareJobs();
+    if (jobs <= 0) {
+        return hardware;
+    }
+    if (jobs > hardware) {
+        std::cerr << "Warning: -j " << jobs << " is more than the " << hardware << " hardware thread(s); using " << hardware << std::endl;
+        return hardware;
+    }
+    return jobs;
+}
+
+TaskPool::TaskPool(int threads) {
+    for (int i = 0; i < threads; ++i) {
+        threads_.emplace_back(&TaskPool::workerLoop, this);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &t : threads_) t.join();
+}
+
+TaskPool &TaskPool::shared() {
+    static TaskPool pool(hardwareJobs() - 1);
+    return pool;
+}
+
+void TaskPool::finish(Group *group) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--group->pending == 0) {
+        group->done.notify_all();
+    }
+}
+
+void TaskPool::workerLoop() {
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            task = queue_.front();
+            queue_.pop_front();
+        }
+        (*task.fn)();
+        finish(task.group);
+    }
+}
+
+void TaskPool::run(std::vector<std::function<void()>> &tasks) {
+    if (tasks.empty()) return;
+    if (threads_.empty() || tasks.size() == 1) {
+        for (auto &fn : tasks) fn();
+        return;
+    }
+
+    // All but the first task go to the queue, the calling thread runs the first one and then
+    // helps with whatever is still queued
+    Group group;
+    group.pending = tasks.size() - 1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 1; i < tasks.size(); ++i) {
+            queue_.push_back(Task{&tasks[i], &group});
+        }
+    }
+    wake_.notify_all();
+
+    tasks[0]();
+    for (;;) {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = std::find_if(queue_.begin(), queue_.end(), [&group](const Task &t) { return t.group == &group; });
+            if (it == queue_.end()) break;
+            task = *it;
+            queue_.erase(it);
+        }
+        (*task.fn)();
+        finish(task.group);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    group.done.wait(lock, [&group] { return group.pending == 0; });
+}
+
+void parallelFor(std::size_t count, int jobs, const std::function<void(std::size_t, int)> &fn, std::size_t chunkSize) {
+    if (count == 0) return;
+
+    if (jobs <= 1 || count == 1) {
+        for (std::size_t i = 0; i < count; ++i) fn(i, 0);
+        return;
+    }
+
+    // No more workers than the shared pool runs at once (its threads and the caller)
+    std::size_t workers = std::min<std::size_t>({static_cast<std::size_t>(jobs), count, static_cast<std::size_t>(hardwareJobs())});
+    if (chunkSize == 0) {
+        // Small enough chunks for stealing to balance the load, large enough to keep it cheap
+        chunkSize = std::max<std::size_t>(1, count / (workers * 16));
+    }
+
+    // Split the range into one contiguous slice per worker
+    std::unique_ptr<Slice[]> slices(new Slice[workers]);
+    for (std::size_t w = 0; w < workers; ++w) {
+        slices[w].next.store(count * w / workers, std::memory_order_relaxed);
+        slices[w].end = count * (w + 1) / workers;
+    }
+
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&](std::size_t self) {
+        try {
+            std::size_t begin, end;
+            // Own slice first, then steal from the others (nearest neighbour first)
+            for (std::size_t k = 0; k < workers; ++k) {
+                Slice &slice = slices[(self + k) % workers];
+                while (claimChunk(slice, chunkSize, begin, end)) {
+                    for (std::size_t i = begin; i < end; ++i) fn(i, static_cast<int>(self));
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+        }
+    };
+
+    // The workers are tasks of the shared pool (the calling thread runs worker 0), so no thread
+    // is started per call; any worker the pool has no thread for is run by the caller
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(workers);
+    for (std::size_t w = 0; w < workers; ++w) {
+        tasks.emplace_back([&worker, w] { worker(w); });
+    }
+    TaskPool::shared().run(tasks);
+
+    if (error) std::rethrow_exception(error);
+}
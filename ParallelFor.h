@@ -0,0 +1,64 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Function to run fn(index, worker) for every index in [0, count) on `jobs` workers, at most
+// hardwareJobs() (see clampJobs). The workers run as tasks of TaskPool::shared() together with
+// the calling thread (worker 0);
+// every worker starts on its own contiguous slice of the range and, once that is done,
+// steals chunks from the slices of the other workers. With jobs <= 1 the loop runs
+// serially on the calling thread (worker 0). It may be called from inside a pool task.
+void parallelFor(std::size_t count, int jobs, const std::function<void(std::size_t, int)> &fn, std::size_t chunkSize = 0);
+
+// Function to return the number of hardware threads (at least 1)
+int hardwareJobs();
+
+// Function to turn a -j value into the number of workers: 0 or less means hardwareJobs(), and
+// more than hardwareJobs() is lowered to it with a warning (the shared pool runs no more at once)
+int clampJobs(int jobs);
+
+// Persistent pool of worker threads for small groups of independent tasks (e.g. the image
+// encodes of one frame). The threads live as long as the pool, so their thread_local
+// buffers are reused from frame to frame.
+class TaskPool {
+public:
+    explicit TaskPool(int threads);
+    ~TaskPool();
+    TaskPool(const TaskPool &) = delete;
+    TaskPool &operator=(const TaskPool &) = delete;
+
+    // Function to run all tasks and wait until they are finished; the calling thread takes
+    // part too, so a pool with 0 threads simply runs the tasks in order. Tasks must not throw.
+    void run(std::vector<std::function<void()>> &tasks);
+
+    // Function to return the process-wide pool (hardwareJobs() - 1 threads, created on first use)
+    static TaskPool &shared();
+
+private:
+    struct Group {
+        std::size_t pending = 0;
+        std::condition_variable done;
+    };
+    struct Task {
+        std::function<void()> *fn;
+        Group *group;
+    };
+
+    void workerLoop();
+    void finish(Group *group);
+
+    std::vector<std::thread> threads_;
+    std::deque<Task> queue_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+};
+
+#endif // PARALLELFOR_H
@@ -0,0 +1,109 @@
+#include "RoiEngine.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+void SummedAreaTable::reserve(int width, int height) {
+    size_t entries = (static_cast<size_t>(width) + 1) * (static_cast<size_t>(height) + 1);
+    sum_.reserve(entries);
+    sumSq_.reserve(entries);
+}
+
+void SummedAreaTable::build(const ThermalFrame &frame) {
+    width_ = frame.width();
+    height_ = frame.height();
+    size_t stride = static_cast<size_t>(width_) + 1;
+    sum_.assign(stride * (height_ + 1), 0.0);
+    sumSq_.assign(stride * (height_ + 1), 0.0);
+
+    for (int y = 0; y < height_; ++y) {
+        const float *row = frame.row(y);
+        const double *sumAbove = &sum_[static_cast<size_t>(y) * stride];
+        const double *sqAbove = &sumSq_[static_cast<size_t>(y) * stride];
+        double *sumRow = &sum_[static_cast<size_t>(y + 1) * stride];
+        double *sqRow = &sumSq_[static_cast<size_t>(y + 1) * stride];
+
+        // Running row sums added to the table row above
+        double rowSum = 0.0;
+        double rowSq = 0.0;
+        for (int x = 0; x < width_; ++x) {
+            double t = row[x];
+            rowSum += t;
+            rowSq += t * t;
+            sumRow[x + 1] = sumAbove[x + 1] + rowSum;
+            sqRow[x + 1] = sqAbove[x + 1] + rowSq;
+        }
+    }
+}
+
+RoiStats SummedAreaTable::query(int x, int y, int width, int height) const {
+    RoiStats stats;
+    int x0 = std::max(x, 0);
+    int y0 = std::max(y, 0);
+    int x1 = std::min(x + width, width_);
+    int y1 = std::min(y + height, height_);
+    if (x0 >= x1 || y0 >= y1) {
+        return stats;
+    }
+
+    size_t stride = static_cast<size_t>(width_) + 1;
+    auto rect = [&](const std::vector<double> &t) {
+        return t[y1 * stride + x1] - t[y0 * stride + x1] - t[y1 * stride + x0] + t[y0 * stride + x0];
+    };
+
+    stats.count = (x1 - x0) * (y1 - y0);
+    double mean = rect(sum_) / stats.count;
+    double variance = std::max(rect(sumSq_) / stats.count - mean * mean, 0.0);
+    stats.mean = static_cast<float>(mean);
+    stats.stddev = static_cast<float>(std::sqrt(variance));
+    return stats;
+}
+
+std::vector<RoiResult> evaluateRois(const ThermalFrame &frame, const Config &config, SummedAreaTable &table) {
+    return judgeRois(measureRois(frame, config, table), config);
+}
+
+std::vector<RoiStats> measureRois(const ThermalFrame &frame, const Config &config, SummedAreaTable &table) {
+    StageTimer timer(STAGE_ROI);
+    std::vector<RoiStats> stats;
+    if (config.rois.empty()) {
+        return stats;
+    }
+
+    table.build(frame);
+    stats.reserve(config.rois.size());
+    for (const auto &roi : config.rois) {
+        stats.push_back(table.query(roi.x, roi.y, roi.width, roi.height));
+    }
+    return stats;
+}
+
+std::vector<RoiResult> judgeRois(const std::vector<RoiStats> &stats, const Config &config) {
+    std::vector<RoiResult> results;
+    results.reserve(stats.size());
+    for (size_t i = 0; i < stats.size() && i < config.rois.size(); ++i) {
+        RoiResult result;
+        result.name = config.rois[i].name;
+        result.stats = stats[i];
+        if (result.stats.count > 0) {
+            result.verdict = result.stats.mean >= config.rois[i].threshold ? 1 : 0;
+        }
+        results.push_back(result);
+    }
+    return results;
+}
+
+std::string formatRoiResults(const std::vector<RoiResult> &results) {
+    std::string line;
+    char buffer[64];
+    for (size_t i = 0; i < results.size(); ++i) {
+        const RoiResult &r = results[i];
+        std::snprintf(buffer, sizeof(buffer), ":%d:%.2f:%.2f", r.verdict, r.stats.mean, r.stats.stddev);
+        if (i > 0) line += '\t';
+        line += r.name;
+        line += buffer;
+    }
+    return line;
+}
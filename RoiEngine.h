@@ -0,0 +1,62 @@
+#ifndef ROIENGINE_H
+#define ROIENGINE_H
+
+#include <string>
+#include <vector>
+
+#include "ConfigReader.h"
+#include "ThermalFrame.h"
+
+// Statistics of one rectangular region of a frame
+struct RoiStats {
+    float mean = 0.0f;
+    float stddev = 0.0f;
+    int count = 0;  // number of pixels inside the frame (0: region is outside)
+};
+
+// Summed-area tables (sum and sum of squares) of a temperature frame.
+// Built once per frame in O(width x height); every rectangle query afterwards is O(1).
+class SummedAreaTable {
+public:
+    // Function to build the tables for a frame (buffers are reused between frames)
+    void build(const ThermalFrame &frame);
+
+    // Function to allocate the tables for a frame size up front
+    void reserve(int width, int height);
+
+    // Function to return mean/stddev of the rectangle, clipped to the frame
+    RoiStats query(int x, int y, int width, int height) const;
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    std::size_t capacity() const { return sum_.capacity(); }  // allocated entries per table
+
+private:
+    // (width + 1) x (height + 1) tables with a zero first row and column
+    std::vector<double> sum_;
+    std::vector<double> sumSq_;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+// Verdict of one named ROI
+struct RoiResult {
+    std::string name;
+    RoiStats stats;
+    int verdict = -1;  // 1 at or above the ROI threshold, 0 below, -1 if the ROI is outside the frame
+};
+
+// Function to evaluate all ROIs of the config on a frame (builds the tables once)
+std::vector<RoiResult> evaluateRois(const ThermalFrame &frame, const Config &config, SummedAreaTable &table);
+
+// Function to measure all ROIs of the config on a frame (builds the tables once), in config order
+std::vector<RoiStats> measureRois(const ThermalFrame &frame, const Config &config, SummedAreaTable &table);
+
+// Function to name the measured ROIs and judge them against their thresholds in the config
+std::vector<RoiResult> judgeRois(const std::vector<RoiStats> &stats, const Config &config);
+
+// Function to format the ROI results as one tab separated line:
+// <name>:<verdict>:<mean>:<stddev> per ROI, in config order
+std::string formatRoiResults(const std::vector<RoiResult> &results);
+
+#endif // ROIENGINE_H
@@ -0,0 +1,302 @@
+#include "SessionShards.h"
+#include "FrameIndex.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+const char MANIFEST_HEADER[] = "mtpSeries-shards 1";
+
+const char RESULTS_MAGIC[8] = {'M', 'T', 'P', 'S', 'H', 'R', 'D', '\0'};
+const uint32_t RESULTS_VERSION = 2;
+
+struct ResultsHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t shard;
+    uint64_t first;
+    uint64_t count;
+    uint64_t manifestKey;
+    uint64_t configKey;
+    uint64_t roiCount;  // entries of the ROI table
+};
+
+struct ResultsRecord {
+    float hotspotMean;
+    float minTemp;
+    float maxTemp;
+    float drillMax;
+    int32_t valid;
+    uint32_t roiCount;  // ROIs of the frame; the ROI table follows the records in frame order
+};
+
+struct ResultsRoi {
+    float mean;
+    float stddev;
+    int32_t count;
+};
+
+static_assert(sizeof(ResultsHeader) == 56, "ResultsHeader layout");
+static_assert(sizeof(ResultsRecord) == 24, "ResultsRecord layout");
+static_assert(sizeof(ResultsRoi) == 12, "ResultsRoi layout");
+
+// FNV-1a, continued over further bytes
+uint64_t hashBytes(uint64_t h, const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+uint64_t hashInt(uint64_t h, int64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        unsigned char byte = static_cast<unsigned char>(value >> (8 * i));
+        h = hashBytes(h, &byte, 1);
+    }
+    return h;
+}
+
+uint64_t manifestKey(const ShardManifest &manifest) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const auto &name : manifest.names) {
+        h = hashBytes(h, name.data(), name.size() + 1);  // with the terminating '\0' as a separator
+    }
+    for (size_t bound : manifest.bounds) {
+        h = hashInt(h, static_cast<int64_t>(bound));
+    }
+    return h;
+}
+
+} // namespace
+
+ShardManifest planShards(const std::vector<std::string> &names, size_t shards) {
+    ShardManifest manifest;
+    manifest.names = names;
+    shards = std::max<size_t>(shards, 1);
+    for (size_t k = 0; k <= shards; ++k) {
+        manifest.bounds.push_back(names.size() * k / shards);
+    }
+    manifest.key = manifestKey(manifest);
+    return manifest;
+}
+
+bool saveShardManifest(const ShardManifest &manifest, const std::string &path) {
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file) {
+            std::cerr << "Error: Could not write manifest: " << tmpPath << std::endl;
+            return false;
+        }
+        file << MANIFEST_HEADER << "\n";
+        file << "frames " << manifest.names.size() << "\n";
+        file << "shards " << manifest.shards() << "\n";
+        for (size_t k = 0; k < manifest.shards(); ++k) {
+            file << "shard " << k << " " << manifest.bounds[k] << " " << manifest.bounds[k + 1] << "\n";
+        }
+        file << "names\n";
+        for (const auto &name : manifest.names) {
+            file << name << "\n";
+        }
+        if (!file) {
+            std::cerr << "Error: Could not write manifest: " << tmpPath << std::endl;
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error: Could not replace manifest: " << path << std::endl;
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool loadShardManifest(const std::string &path, ShardManifest &manifest) {
+    manifest = ShardManifest();
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Could not open manifest: " << path << " (write it with --plan N)" << std::endl;
+        return false;
+    }
+
+    std::string line, word;
+    size_t frames = 0, shards = 0;
+    bool ok = std::getline(file, line) && line == MANIFEST_HEADER;
+    ok = ok && std::getline(file, line) && (std::istringstream(line) >> word >> frames) && word == "frames";
+    ok = ok && std::getline(file, line) && (std::istringstream(line) >> word >> shards) && word == "shards" && shards > 0;
+
+    // Consecutive shards covering all frames
+    manifest.bounds.push_back(0);
+    for (size_t k = 0; ok && k < shards; ++k) {
+        size_t index, first, end;
+        ok = std::getline(file, line) && (std::istringstream(line) >> word >> index >> first >> end) && word == "shard"
+             && index == k && first == manifest.bounds.back() && end >= first && end <= frames;
+        manifest.bounds.push_back(end);
+    }
+    ok = ok && manifest.bounds.back() == frames && std::getline(file, line) && line == "names";
+
+    manifest.names.reserve(ok ? frames : 0);
+    while (ok && manifest.names.size() < frames && std::getline(file, line)) {
+        manifest.names.push_back(line);
+    }
+    if (!ok || manifest.names.size() != frames) {
+        std::cerr << "Error: Invalid manifest: " << path << std::endl;
+        manifest = ShardManifest();
+        return false;
+    }
+    manifest.key = manifestKey(manifest);
+    return true;
+}
+
+uint64_t shardConfigKey(const Config &config) {
+    return hashInt(1469598103934665603ULL, static_cast<int64_t>(frameGeometryKey(config)));
+}
+
+std::string shardResultPath(const std::string &manifestPath, size_t shard) {
+    std::string base = manifestPath;
+    if (base.size() > 4 && base.compare(base.size() - 4, 4, ".txt") == 0) {
+        base.resize(base.size() - 4);
+    }
+    return base + "_" + std::to_string(shard) + ".res";
+}
+
+bool saveShardResults(const ShardResults &results, const std::string &path) {
+    std::vector<ResultsRecord> records;
+    std::vector<ResultsRoi> rois;
+    records.reserve(results.stats.size());
+    for (size_t i = 0; i < results.stats.size(); ++i) {
+        const FrameStats &s = results.stats[i];
+        ResultsRecord r{};
+        r.hotspotMean = s.hotspotMean;
+        r.minTemp = s.minTemp;
+        r.maxTemp = s.maxTemp;
+        r.drillMax = s.drillMax;
+        r.valid = s.valid ? 1 : 0;
+        if (i < results.rois.size()) {
+            r.roiCount = static_cast<uint32_t>(results.rois[i].size());
+            for (const RoiStats &roi : results.rois[i]) {
+                rois.push_back(ResultsRoi{roi.mean, roi.stddev, roi.count});
+            }
+        }
+        records.push_back(r);
+    }
+
+    ResultsHeader header{};
+    std::memcpy(header.magic, RESULTS_MAGIC, sizeof(RESULTS_MAGIC));
+    header.version = RESULTS_VERSION;
+    header.shard = static_cast<uint32_t>(results.shard);
+    header.first = results.first;
+    header.count = records.size();
+    header.manifestKey = results.manifestKey;
+    header.configKey = results.configKey;
+    header.roiCount = rois.size();
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Error: Could not write shard results: " << tmpPath << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(ResultsRecord));
+        file.write(reinterpret_cast<const char *>(rois.data()), rois.size() * sizeof(ResultsRoi));
+        if (!file) {
+            std::cerr << "Error: Could not write shard results: " << tmpPath << std::endl;
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error: Could not replace shard results: " << path << std::endl;
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    countStats(COUNTER_FILES_WRITTEN);
+    countStats(COUNTER_BYTES_WRITTEN, sizeof(header) + records.size() * sizeof(ResultsRecord) + rois.size() * sizeof(ResultsRoi));
+    return true;
+}
+
+bool loadShardResults(const std::string &path, const ShardManifest &manifest, size_t shard, uint64_t configKey, ShardResults &results) {
+    results = ShardResults();
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: No results of shard " << shard << " yet: " << path << std::endl;
+        return false;
+    }
+
+    ResultsHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || std::memcmp(header.magic, RESULTS_MAGIC, sizeof(RESULTS_MAGIC)) != 0 || header.version != RESULTS_VERSION) {
+        std::cerr << "Error: Invalid shard results: " << path << std::endl;
+        return false;
+    }
+    if (header.manifestKey != manifest.key || shard >= manifest.shards() || header.shard != shard
+        || header.first != manifest.bounds[shard] || header.count != manifest.bounds[shard + 1] - manifest.bounds[shard]) {
+        std::cerr << "Error: Shard results of another manifest: " << path << " (run shard " << shard << " again)" << std::endl;
+        return false;
+    }
+    if (header.configKey != configKey) {
+        std::cerr << "Error: Shard results of another config.txt: " << path << " (run shard " << shard << " again)" << std::endl;
+        return false;
+    }
+
+    // The records and the ROI table must fit in the rest of the file before anything is allocated
+    file.seekg(0, std::ios::end);
+    uint64_t remaining = static_cast<uint64_t>(file.tellg()) - sizeof(header);
+    file.seekg(sizeof(header));
+    if (header.count > remaining / sizeof(ResultsRecord)
+        || header.roiCount > (remaining - header.count * sizeof(ResultsRecord)) / sizeof(ResultsRoi)) {
+        std::cerr << "Error: Truncated shard results: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<ResultsRecord> records(header.count);
+    std::vector<ResultsRoi> rois(header.roiCount);
+    if (!file.read(reinterpret_cast<char *>(records.data()), records.size() * sizeof(ResultsRecord))
+        || !file.read(reinterpret_cast<char *>(rois.data()), rois.size() * sizeof(ResultsRoi))) {
+        std::cerr << "Error: Truncated shard results: " << path << std::endl;
+        return false;
+    }
+
+    results.shard = shard;
+    results.first = header.first;
+    results.manifestKey = header.manifestKey;
+    results.configKey = header.configKey;
+    results.stats.resize(records.size());
+    results.rois.resize(records.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < records.size(); ++i) {
+        const ResultsRecord &r = records[i];
+        FrameStats &s = results.stats[i];
+        s.hotspotMean = r.hotspotMean;
+        s.minTemp = r.minTemp;
+        s.maxTemp = r.maxTemp;
+        s.drillMax = r.drillMax;
+        s.valid = r.valid != 0;
+        if (offset + r.roiCount > rois.size()) {
+            std::cerr << "Error: Invalid shard results: " << path << std::endl;
+            results = ShardResults();
+            return false;
+        }
+        for (uint32_t k = 0; k < r.roiCount; ++k) {
+            const ResultsRoi &roi = rois[offset + k];
+            RoiStats roiStats;
+            roiStats.mean = roi.mean;
+            roiStats.stddev = roi.stddev;
+            roiStats.count = roi.count;
+            results.rois[i].push_back(roiStats);
+        }
+        offset += r.roiCount;
+    }
+    return true;
+}
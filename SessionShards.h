@@ -0,0 +1,62 @@
+#ifndef SESSIONSHARDS_H
+#define SESSIONSHARDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ConfigReader.h"
+#include "FrameProcessor.h"
+#include "RoiEngine.h"
+
+// A session split into shards that are processed independently (by separate processes, on any
+// machine that sees the session) and merged afterwards:
+//   manifest   the sorted frame names of the session and the shard boundaries (text file);
+//              the names are relative to the session, so every node may mount it elsewhere
+//   results    one file per shard with the statistics (and ROI statistics) of its frames
+// A result file records the key of its manifest and of the config values its statistics
+// depend on, so the merge never mixes shards of another plan or another geometry.
+struct ShardManifest {
+    std::vector<std::string> names;  // frame names in session order
+    std::vector<size_t> bounds;      // shard k holds frames [bounds[k], bounds[k + 1])
+    uint64_t key = 0;                // hash of the names and bounds
+
+    size_t shards() const { return bounds.empty() ? 0 : bounds.size() - 1; }
+};
+
+// Results of one shard (frames [first, first + stats.size()) of the manifest)
+struct ShardResults {
+    size_t shard = 0;
+    size_t first = 0;
+    uint64_t manifestKey = 0;
+    uint64_t configKey = 0;
+    std::vector<FrameStats> stats;
+    std::vector<std::vector<RoiStats>> rois;  // ROI statistics of every frame (empty without roi_* entries)
+};
+
+// Function to split the frames into `shards` runs of consecutive frames of (nearly) equal length
+ShardManifest planShards(const std::vector<std::string> &names, size_t shards);
+
+// Function to write a manifest; prints the reason and returns false on error
+bool saveShardManifest(const ShardManifest &manifest, const std::string &path);
+
+// Function to read a manifest written by saveShardManifest; prints the reason and returns false on error
+bool loadShardManifest(const std::string &path, ShardManifest &manifest);
+
+// Function to hash the config values the shard results depend on: the frame geometry, ROI
+// rectangles included (as frameGeometryKey); the hot spot and ROI thresholds are applied at the merge
+uint64_t shardConfigKey(const Config &config);
+
+// Function to return the name of the result file of shard k: <manifest without .txt>_<k>.res
+std::string shardResultPath(const std::string &manifestPath, size_t shard);
+
+// Function to write the results of a shard (to a temporary file that is then renamed, so a
+// merge never sees a partly written shard)
+bool saveShardResults(const ShardResults &results, const std::string &path);
+
+// Function to read the results of a shard and check them against the manifest and config key;
+// prints the reason and returns false when they are missing, stale or corrupt
+bool loadShardResults(const std::string &path, const ShardManifest &manifest, size_t shard, uint64_t configKey, ShardResults &results);
+
+#endif // SESSIONSHARDS_H
@@ -0,0 +1,129 @@
+#include "SessionStats.h"
+#include "FrameProcessor.h"
+
+#include <algorithm>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+
+bool PixelStatistics::add(const ThermalFrame &frame) {
+    const int width = frame.width();
+    const int height = frame.height();
+
+    // The first frame initialises the accumulators
+    if (count_ == 0) {
+        width_ = width;
+        height_ = height;
+        size_t pixels = static_cast<size_t>(width) * height;
+        max_.resize(pixels);
+        mean_.resize(pixels);
+        m2_.resize(pixels);
+        for (int y = 0; y < height; ++y) {
+            const float *row = frame.row(y);
+            size_t offset = static_cast<size_t>(y) * width;
+            for (int x = 0; x < width; ++x) {
+                max_[offset + x] = row[x];
+                mean_[offset + x] = row[x];
+                m2_[offset + x] = 0.0;
+            }
+        }
+        count_ = 1;
+        return true;
+    }
+
+    if (width != width_ || height != height_) {
+        return false;
+    }
+
+    // Welford: update the mean and the sum of squared differences with one new sample per pixel
+    ++count_;
+    const double n = static_cast<double>(count_);
+    for (int y = 0; y < height; ++y) {
+        const float *row = frame.row(y);
+        size_t offset = static_cast<size_t>(y) * width;
+        float *maxRow = max_.data() + offset;
+        double *meanRow = mean_.data() + offset;
+        double *m2Row = m2_.data() + offset;
+        for (int x = 0; x < width; ++x) {
+            double value = row[x];
+            double delta = value - meanRow[x];
+            meanRow[x] += delta / n;
+            m2Row[x] += delta * (value - meanRow[x]);
+            maxRow[x] = std::max(maxRow[x], row[x]);
+        }
+    }
+    return true;
+}
+
+bool PixelStatistics::merge(const PixelStatistics &other) {
+    if (other.count_ == 0) {
+        return true;
+    }
+    if (count_ == 0) {
+        width_ = other.width_;
+        height_ = other.height_;
+        count_ = other.count_;
+        max_ = other.max_;
+        mean_ = other.mean_;
+        m2_ = other.m2_;
+        return true;
+    }
+    if (other.width_ != width_ || other.height_ != height_) {
+        return false;
+    }
+
+    // Chan et al.: combine the means and the sums of squared differences of two sample sets
+    const double na = static_cast<double>(count_);
+    const double nb = static_cast<double>(other.count_);
+    const double n = na + nb;
+    for (size_t i = 0; i < mean_.size(); ++i) {
+        double delta = other.mean_[i] - mean_[i];
+        mean_[i] += delta * nb / n;
+        m2_[i] += other.m2_[i] + delta * delta * na * nb / n;
+        max_[i] = std::max(max_[i], other.max_[i]);
+    }
+    count_ += other.count_;
+    return true;
+}
+
+void PixelStatistics::maxMap(ThermalFrame &map) const {
+    map.resize(width_, height_);
+    for (int y = 0; y < height_; ++y) {
+        std::copy_n(max_.data() + static_cast<size_t>(y) * width_, width_, map.row(y));
+    }
+}
+
+void PixelStatistics::meanMap(ThermalFrame &map) const {
+    map.resize(width_, height_);
+    for (int y = 0; y < height_; ++y) {
+        const double *mean = mean_.data() + static_cast<size_t>(y) * width_;
+        float *row = map.row(y);
+        for (int x = 0; x < width_; ++x) {
+            row[x] = static_cast<float>(mean[x]);
+        }
+    }
+}
+
+void PixelStatistics::varianceMap(ThermalFrame &map) const {
+    map.resize(width_, height_);
+    const double n = static_cast<double>(std::max<uint64_t>(count_, 1));
+    for (int y = 0; y < height_; ++y) {
+        const double *m2 = m2_.data() + static_cast<size_t>(y) * width_;
+        float *row = map.row(y);
+        for (int x = 0; x < width_; ++x) {
+            row[x] = static_cast<float>(m2[x] / n);
+        }
+    }
+}
+
+void saveStatisticsMap(const ThermalFrame &map, const std::string &base) {
+    saveTemperatureMatrixToFile(map, base);
+
+    // Heatmap: the linear min-max image of the map through a false-colour palette
+    TemperatureImages images;
+    quantizeTemperatureFrame(map, IMAGE_LIN, images);
+    cv::Mat heatmap;
+    cv::applyColorMap(images.img_lin, heatmap, cv::COLORMAP_INFERNO);
+    if (!cv::imwrite(base + ".png", heatmap)) {
+        std::cerr << "Could not write heatmap: " << base << ".png" << std::endl;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef SESSIONSTATS_H
+#define SESSIONSTATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ThermalFrame.h"
+
+// Per-pixel running statistics over the frames of a session: maximum, mean and variance.
+// Frames are added one at a time (Welford), so memory stays O(frame) for any session length;
+// two accumulators of disjoint frame sets can be merged (Chan et al.), so every worker thread
+// keeps its own and they are combined afterwards.
+class PixelStatistics {
+public:
+    // Function to forget all frames (the buffers are kept for the next ones)
+    void clear() { count_ = 0; }
+
+    // Function to add a frame; false (frame ignored) if its size differs from the previous ones
+    bool add(const ThermalFrame &frame);
+
+    // Function to add the frames of another accumulator; false if the frame sizes differ
+    bool merge(const PixelStatistics &other);
+
+    uint64_t count() const { return count_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Functions to write the maps into a frame: maximum and mean in Celsius, variance in Celsius^2
+    // (population variance of the frames added so far)
+    void maxMap(ThermalFrame &map) const;
+    void meanMap(ThermalFrame &map) const;
+    void varianceMap(ThermalFrame &map) const;
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    uint64_t count_ = 0;
+    std::vector<float> max_;
+    std::vector<double> mean_;
+    std::vector<double> m2_;  // sum of squared differences from the mean
+};
+
+// Function to save a statistics map as a tab-delimited matrix (<base>.csv) and a false-colour
+// heatmap scaled to the map's min-max range (<base>.png)
+void saveStatisticsMap(const ThermalFrame &map, const std::string &base);
+
+#endif // SESSIONSTATS_H
@@ -0,0 +1,25 @@
+#include "ShotDetector.h"
+
+bool ShotDetector::feed(const std::string &file, int verdict, const FrameStats &stats) {
+    if (done_) {
+        return true;
+    }
+
+    if (verdict == 1) {
+        if (!foundFirst_) {
+            beforeShot_ = file;
+            beforeStats_ = stats;
+            foundFirst_ = true;
+            zeroCount_ = 0;
+        } else if (zeroCount_ >= requiredZeros_) {
+            afterShot_ = file;
+            afterStats_ = stats;
+            done_ = true;
+        }
+    } else {
+        if (foundFirst_) {
+            ++zeroCount_;
+        }
+    }
+    return done_;
+}
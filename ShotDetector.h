@@ -0,0 +1,42 @@
+#ifndef SHOTDETECTOR_H
+#define SHOTDETECTOR_H
+
+#include <string>
+
+#include "FrameProcessor.h"
+
+#define ZERO_COUNT 4    //how many frames has to be without hotspot 
+                        // to be considered as a gap (oneShot mode) 
+                        // between beforeShot and afterShot
+
+// State machine of the one-shot mode: first hot frame (beforeShot), then at least ZERO_COUNT
+// frames without the hot spot, then the next hot frame (afterShot). Frames are fed one at a
+// time in sorted order, so the same detector serves a full scan and a live directory.
+class ShotDetector {
+public:
+    explicit ShotDetector(int zeroCount = ZERO_COUNT) : requiredZeros_(zeroCount) {}
+
+    // Function to feed the next frame (verdict: 1 hot, 0 cold, -1 unreadable = cold);
+    // returns true once both shots have been found
+    bool feed(const std::string &file, int verdict, const FrameStats &stats);
+
+    bool done() const { return done_; }
+    bool foundFirst() const { return foundFirst_; }
+    int zeroCount() const { return zeroCount_; }
+    const std::string &beforeShot() const { return beforeShot_; }
+    const std::string &afterShot() const { return afterShot_; }
+    const FrameStats &beforeStats() const { return beforeStats_; }
+    const FrameStats &afterStats() const { return afterStats_; }
+
+private:
+    int requiredZeros_;
+    bool foundFirst_ = false;
+    bool done_ = false;
+    int zeroCount_ = 0;
+    std::string beforeShot_;
+    std::string afterShot_;
+    FrameStats beforeStats_;
+    FrameStats afterStats_;
+};
+
+#endif // SHOTDETECTOR_H
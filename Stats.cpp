@@ -0,0 +1,81 @@
+#include "Stats.h"
+
+#include <cstdio>
+#include <ostream>
+
+std::atomic<bool> statsEnabled(false);
+
+namespace {
+
+const char *STAGE_NAMES[STAGE_COUNT] = {"load", "convert", "quantize", "png", "csv", "npy", "jpg", "frame_stats", "roi", "index", "video"};
+const char *COUNTER_NAMES[COUNTER_COUNT] = {"bytes_read", "frames_decoded", "files_written", "bytes_written", "index_hits", "pool_allocations"};
+
+std::atomic<uint64_t> stageCalls[STAGE_COUNT];
+std::atomic<uint64_t> stageNanoseconds[STAGE_COUNT];
+std::atomic<uint64_t> counters[COUNTER_COUNT];
+std::chrono::steady_clock::time_point statsStart;
+
+} // namespace
+
+void enableStats() {
+    statsStart = std::chrono::steady_clock::now();
+    statsEnabled.store(true);
+}
+
+void addStatsCounter(StatsCounter counter, uint64_t value) {
+    counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+void addStageTime(StatsStage stage, uint64_t nanoseconds) {
+    stageCalls[stage].fetch_add(1, std::memory_order_relaxed);
+    stageNanoseconds[stage].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+bool parseStatsFlag(const std::string &arg, bool &json) {
+    if (arg == "--stats" || arg == "--stats=table") {
+        json = false;
+        return true;
+    }
+    if (arg == "--stats=json") {
+        json = true;
+        return true;
+    }
+    return false;
+}
+
+void printStats(std::ostream &out, bool json) {
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - statsStart).count();
+    char line[160];
+
+    if (json) {
+        out << "{\"wall_ms\": " << wallMs << ", \"stages\": {";
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            std::snprintf(line, sizeof(line), "%s\"%s\": {\"calls\": %llu, \"total_ms\": %.3f}", s ? ", " : "", STAGE_NAMES[s],
+                          static_cast<unsigned long long>(stageCalls[s].load()), stageNanoseconds[s].load() / 1e6);
+            out << line;
+        }
+        out << "}, \"counters\": {";
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            out << (c ? ", " : "") << "\"" << COUNTER_NAMES[c] << "\": " << counters[c].load();
+        }
+        out << "}}" << std::endl;
+        return;
+    }
+
+    std::snprintf(line, sizeof(line), "%-12s %10s %12s %12s", "stage", "calls", "total ms", "mean us");
+    out << line << std::endl;
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        uint64_t calls = stageCalls[s].load();
+        if (calls == 0) continue;
+        double totalMs = stageNanoseconds[s].load() / 1e6;
+        std::snprintf(line, sizeof(line), "%-12s %10llu %12.3f %12.1f", STAGE_NAMES[s], static_cast<unsigned long long>(calls), totalMs,
+                      totalMs * 1000.0 / calls);
+        out << line << std::endl;
+    }
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        std::snprintf(line, sizeof(line), "%-14s %llu", COUNTER_NAMES[c], static_cast<unsigned long long>(counters[c].load()));
+        out << line << std::endl;
+    }
+    std::snprintf(line, sizeof(line), "%-14s %.3f", "wall ms", wallMs);
+    out << line << std::endl;
+}
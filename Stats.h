@@ -0,0 +1,96 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// Stage timers and counters of the pipeline (mtpFrame/mtpSeries --stats).
+// Collection is off until enableStats(); a disabled timer or counter costs one predicted branch.
+// Building with -DMTP_NO_STATS removes them entirely. Totals are atomics, so any worker thread
+// may add to them; stage times are summed over all threads (CPU time, not wall time).
+
+enum StatsStage {
+    STAGE_LOAD,         // opening/mapping a frame (Tc0File)
+    STAGE_CONVERT,      // raw words to Celsius
+    STAGE_QUANTIZE,     // min/max and the 16bit/8bit/lin images
+    STAGE_PNG,          // PNG encode and write
+    STAGE_CSV,          // CSV format and write
+    STAGE_NPY,          // .npy write
+    STAGE_JPG,          // YUYV to BGR, JPEG encode and write
+    STAGE_FRAME_STATS,  // hot spot / min / max / drill statistics from the raw words
+    STAGE_ROI,          // summed-area tables and named ROIs
+    STAGE_INDEX,        // frame index load/save
+    STAGE_VIDEO,        // false colour, overlays and video encode (mtpSeries --video)
+    STAGE_COUNT
+};
+
+enum StatsCounter {
+    COUNTER_BYTES_READ,      // bytes of the frame files (or archive members) opened
+    COUNTER_FRAMES_DECODED,  // frames opened and validated
+    COUNTER_FILES_WRITTEN,
+    COUNTER_BYTES_WRITTEN,
+    COUNTER_INDEX_HITS,      // frames answered from the index without decoding
+    COUNTER_POOL_ALLOCATIONS,  // frame pool buffers that had to be (re)allocated (FramePool::allocations())
+    COUNTER_COUNT
+};
+
+extern std::atomic<bool> statsEnabled;
+
+// Function to start collecting (call before the worker threads start)
+void enableStats();
+
+void addStatsCounter(StatsCounter counter, uint64_t value);
+void addStageTime(StatsStage stage, uint64_t nanoseconds);
+
+// Function to add to a counter (no-op while collection is off)
+inline void countStats(StatsCounter counter, uint64_t value = 1) {
+#ifndef MTP_NO_STATS
+    if (__builtin_expect(statsEnabled.load(std::memory_order_relaxed), 0)) {
+        addStatsCounter(counter, value);
+    }
+#else
+    (void)counter;
+    (void)value;
+#endif
+}
+
+// Times the enclosing scope as one call of a stage
+class StageTimer {
+public:
+    explicit StageTimer(StatsStage stage) : stage_(stage) {
+#ifndef MTP_NO_STATS
+        if (__builtin_expect(statsEnabled.load(std::memory_order_relaxed), 0)) {
+            start_ = std::chrono::steady_clock::now();
+            running_ = true;
+        }
+#endif
+    }
+
+    ~StageTimer() {
+#ifndef MTP_NO_STATS
+        if (running_) {
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            addStageTime(stage_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+#endif
+    }
+
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+
+private:
+    StatsStage stage_;
+    std::chrono::steady_clock::time_point start_;
+    bool running_ = false;
+};
+
+// Function to parse a --stats / --stats=table / --stats=json argument; false if it is not one
+bool parseStatsFlag(const std::string &arg, bool &json);
+
+// Function to print the totals as a table or as one JSON object (wall time since enableStats())
+void printStats(std::ostream &out, bool json);
+
+#endif // STATS_H
@@ -0,0 +1,198 @@
+#include "Tc0File.h"
+#include "TcsArchive.h"
+#include "Stats.h"
+
+#include <atomic>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const std::size_t HEADER_WORDS = 4;
+
+std::atomic<bool> typeWarned(false);
+
+// Function to return the size of one element of an OpenCV type code (depth x channels)
+std::size_t elementSize(int type) {
+    static const std::size_t depthBytes[8] = {1, 1, 2, 2, 4, 4, 8, 2};
+    return depthBytes[type & 7] * static_cast<std::size_t>((type >> 3) + 1);
+}
+
+} // namespace
+
+Tc0File::~Tc0File() {
+    close();
+}
+
+void Tc0File::close() {
+    if (map_) {
+        munmap(map_, mapSize_);
+        map_ = nullptr;
+        mapSize_ = 0;
+    }
+    archive_.reset();
+    words_ = nullptr;
+    rows_ = cols_ = type_ = channels_ = 0;
+}
+
+bool Tc0File::open(const std::string &filename) {
+    StageTimer timer(STAGE_LOAD);
+    close();
+
+    std::string archivePath, name;
+    if (splitArchiveMember(filename, archivePath, name)) {
+        return openMember(filename, archivePath, name);
+    }
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open file." << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "Cannot open file." << std::endl;
+        ::close(fd);
+        return false;
+    }
+    std::size_t fileSize = static_cast<std::size_t>(st.st_size);
+
+    if (fileSize < HEADER_WORDS * sizeof(uint16_t)) {
+        std::cerr << "Invalid .tc0 file (no header): " << filename << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void *map = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+        madvise(map, fileSize, MADV_SEQUENTIAL);
+        map_ = map;
+        mapSize_ = fileSize;
+        words_ = static_cast<const uint16_t *>(map);
+    } else {
+        // Fall back to a single bulk read into the reusable buffer
+        buffer_.resize(fileSize / sizeof(uint16_t));
+        char *dst = reinterpret_cast<char *>(buffer_.data());
+        std::size_t wanted = buffer_.size() * sizeof(uint16_t);
+        std::size_t done = 0;
+        while (done < wanted) {
+            ssize_t n = ::read(fd, dst + done, wanted - done);
+            if (n <= 0) break;
+            done += static_cast<std::size_t>(n);
+        }
+        if (done < wanted) {
+            std::cerr << "Cannot read file: " << filename << std::endl;
+            ::close(fd);
+            return false;
+        }
+        words_ = buffer_.data();
+    }
+    ::close(fd);
+
+    return readHeader(filename, fileSize);
+}
+
+bool Tc0File::openMember(const std::string &filename, const std::string &archivePath, const std::string &name) {
+    archive_ = TcsArchive::shared(archivePath);
+    if (!archive_) {
+        return false;
+    }
+
+    long index = archive_->find(name);
+    if (index < 0) {
+        std::cerr << "Error: No frame " << name << " in archive " << archivePath << std::endl;
+        close();
+        return false;
+    }
+
+    const TcsArchive::Frame &frame = archive_->frame(index);
+    if (frame.rawSize < HEADER_WORDS * sizeof(uint16_t)) {
+        std::cerr << "Invalid .tc0 file (no header): " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    // Stored frames are used in place, compressed ones are decoded into the reusable buffer
+    if (const uint8_t *stored = archive_->storedData(index)) {
+        words_ = reinterpret_cast<const uint16_t *>(stored);
+    } else if (archive_->read(index, buffer_)) {
+        words_ = buffer_.data();
+    } else {
+        close();
+        return false;
+    }
+
+    return readHeader(filename, frame.rawSize);
+}
+
+bool Tc0File::readHeader(const std::string &filename, std::size_t fileSize) {
+    // Read the headers (rows, cols, type, channels)
+    rows_ = words_[0];
+    cols_ = words_[1];
+    type_ = words_[2];
+    channels_ = words_[3];
+
+    // The payload is read as rows x cols words of 2 bytes, whatever the type and channel words say
+    std::size_t payloadWords = static_cast<std::size_t>(rows_) * cols_;
+    std::size_t availableWords = fileSize / sizeof(uint16_t) - HEADER_WORDS;
+    if (rows_ < 2 || cols_ < 1 || availableWords < payloadWords) {
+        std::cerr << "Invalid .tc0 header in " << filename << ": rows=" << rows_ << " cols=" << cols_
+                  << " type=" << type_ << " channels=" << channels_ << " size=" << fileSize << std::endl;
+        close();
+        return false;
+    }
+    if ((elementSize(type_) != sizeof(uint16_t) || channels_ != (type_ >> 3) + 1) && !typeWarned.exchange(true)) {
+        std::cerr << "Warning: Unexpected .tc0 type=" << type_ << " channels=" << channels_ << " in " << filename
+                  << " (read as 16-bit words; reported once)" << std::endl;
+    }
+
+    countStats(COUNTER_BYTES_READ, fileSize);
+    countStats(COUNTER_FRAMES_DECODED);
+    return true;
+}
+
+void Tc0File::load() const {
+    if (!words_) {
+        return;
+    }
+    std::size_t bytes = (HEADER_WORDS + static_cast<std::size_t>(rows_) * cols_) * sizeof(uint16_t);
+    if (map_) {
+        madvise(map_, mapSize_, MADV_WILLNEED);
+    }
+
+    // One read per page (the readahead started above usually has them in memory already)
+    const volatile unsigned char *bytesIn = reinterpret_cast<const unsigned char *>(words_);
+    unsigned char sum = 0;
+    for (std::size_t i = 0; i < bytes; i += 4096) {
+        sum ^= bytesIn[i];
+    }
+    (void)sum;
+}
+
+void adviseFrameFile(const std::string &filename) {
+    std::string archivePath, name;
+    if (splitArchiveMember(filename, archivePath, name)) {
+        return;
+    }
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;  // reported when the frame is opened
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+}
+
+RawSpan Tc0File::imageData() const {
+    // Upper half of the data
+    return RawSpan(words_ + HEADER_WORDS, static_cast<std::size_t>(rows_ / 2) * cols_);
+}
+
+RawSpan Tc0File::temperatureData() const {
+    // Lower half of the data
+    return RawSpan(words_ + HEADER_WORDS + static_cast<std::size_t>(rows_ / 2) * cols_,
+                   static_cast<std::size_t>(rows_ / 2) * cols_);
+}
@@ -0,0 +1,76 @@
+#ifndef TC0FILE_H
+#define TC0FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Non-owning view of a contiguous run of raw 16-bit words
+struct RawSpan {
+    const uint16_t *data = nullptr;
+    std::size_t size = 0;
+
+    RawSpan() = default;
+    RawSpan(const uint16_t *d, std::size_t n) : data(d), size(n) {}
+    RawSpan(const std::vector<uint16_t> &v) : data(v.data()), size(v.size()) {}
+
+    const uint16_t &operator[](std::size_t i) const { return data[i]; }
+    const uint16_t *begin() const { return data; }
+    const uint16_t *end() const { return data + size; }
+    bool empty() const { return size == 0; }
+};
+
+class TcsArchive;
+
+// Read-only .tc0 frame mapped into memory.
+// Layout: 4 x uint16 header (rows, cols, type, channels) followed by rows x cols words;
+// the upper rows/2 rows hold the visible image (YUYV), the lower rows/2 rows the raw temperature.
+// The spans returned by imageData()/temperatureData() stay valid until close() or the next open().
+// A frame of a packed session ("<archive>.tcs#<name>", see TcsArchive.h) is opened from the
+// archive: stored frames are used straight from its mapping, compressed ones are decoded.
+class Tc0File {
+public:
+    Tc0File() = default;
+    ~Tc0File();
+    Tc0File(const Tc0File &) = delete;
+    Tc0File &operator=(const Tc0File &) = delete;
+
+    // Function to map a file and validate its header; prints the reason and returns false on error
+    bool open(const std::string &filename);
+    void close();
+    bool isOpen() const { return words_ != nullptr; }
+
+    // Function to bring the whole open frame into memory now (the pages of a mapping are read
+    // in), so that a later stage working on it does not wait for the disk
+    void load() const;
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int type() const { return type_; }
+    int channels() const { return channels_; }
+
+    RawSpan imageData() const;
+    RawSpan temperatureData() const;
+
+private:
+    bool openMember(const std::string &filename, const std::string &archivePath, const std::string &name);
+    bool readHeader(const std::string &filename, std::size_t fileSize);
+
+    void *map_ = nullptr;
+    std::size_t mapSize_ = 0;
+    std::vector<uint16_t> buffer_;  // used when the file cannot be mapped (reused across opens)
+    std::shared_ptr<const TcsArchive> archive_;  // archive of the open frame, if any
+    const uint16_t *words_ = nullptr;
+    int rows_ = 0;
+    int cols_ = 0;
+    int type_ = 0;
+    int channels_ = 0;
+};
+
+// Function to let the kernel start reading a frame file in the background (posix_fadvise
+// WILLNEED) and return at once; frames of an archive need no hint (the archive is mapped)
+void adviseFrameFile(const std::string &filename);
+
+#endif // TC0FILE_H
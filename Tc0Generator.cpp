@@ -0,0 +1,125 @@
+#include "Tc0Generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// Integer hash of (seed, frame, pixel) giving a uniform value in [0, 1)
+float hashNoise(uint32_t seed, uint32_t frame, uint32_t pixel) {
+    uint32_t h = seed * 0x9E3779B1u ^ frame * 0x85EBCA77u ^ pixel * 0xC2B2AE3Du;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return static_cast<float>(h >> 8) / 16777216.0f;
+}
+
+uint16_t celsiusToRaw(float t) {
+    float raw = std::round((t + 273.15f) * 64.0f);
+    return static_cast<uint16_t>(std::min(std::max(raw, 0.0f), 65535.0f));
+}
+
+} // namespace
+
+bool parseTrajectory(const std::string &text, SyntheticSession &session) {
+    std::istringstream iss(text);
+    char c1, c2, c3;
+    int x0, y0, x1, y1;
+    if (!(iss >> x0 >> c1 >> y0 >> c2 >> x1 >> c3 >> y1) || c1 != ',' || c2 != ',' || c3 != ',') {
+        return false;
+    }
+    session.startX = x0;
+    session.startY = y0;
+    session.endX = x1;
+    session.endY = y1;
+    return true;
+}
+
+void generateSyntheticFrame(const SyntheticSession &session, int index, std::vector<uint16_t> &words) {
+    const int cols = session.width;
+    const int height = session.height;
+    const std::size_t pixels = static_cast<std::size_t>(cols) * height;
+    words.resize(4 + 2 * pixels);
+
+    // Header: rows, cols, type (CV_16UC1), channels
+    words[0] = static_cast<uint16_t>(2 * height);
+    words[1] = static_cast<uint16_t>(cols);
+    words[2] = 2;
+    words[3] = 1;
+
+    // Upper half: YUYV test pattern (Y ramps, U/V change per frame)
+    uint16_t *image = words.data() + 4;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            uint8_t luma = static_cast<uint8_t>((x + y + index) & 0xFF);
+            uint8_t chroma = static_cast<uint8_t>((x & 1) ? 128 + (index & 63) : 128 - (y & 63));
+            image[static_cast<std::size_t>(y) * cols + x] = static_cast<uint16_t>(luma | (chroma << 8));
+        }
+    }
+
+    // Hot spot position on its trajectory
+    int hotLast = session.hotLast < 0 ? session.frames - 1 : session.hotLast;
+    bool hot = index >= session.hotFirst && index <= hotLast;
+    float progress = session.frames > 1 ? static_cast<float>(index) / (session.frames - 1) : 0.0f;
+    float cx = session.startX + (session.endX - session.startX) * progress;
+    float cy = session.startY + (session.endY - session.startY) * progress;
+    float radius = static_cast<float>(std::max(session.hotspotRadius, 1));
+
+    // Lower half: temperature words
+    uint16_t *temperature = image + pixels;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            uint32_t pixel = static_cast<uint32_t>(y * cols + x);
+            float t = session.ambient + 3.0f * static_cast<float>(y) / height
+                      + session.noise * (2.0f * hashNoise(session.seed, static_cast<uint32_t>(index), pixel) - 1.0f);
+            if (hot) {
+                float dx = (x - cx) / radius;
+                float dy = (y - cy) / radius;
+                float d2 = dx * dx + dy * dy;
+                if (d2 < 4.0f) {
+                    t = std::max(t, session.ambient + (session.hotspotTemp - session.ambient) * std::exp(-d2));
+                }
+            }
+            temperature[pixel] = celsiusToRaw(t);
+        }
+    }
+}
+
+std::string syntheticFrameName(int index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06d.tc0", index);
+    return name;
+}
+
+bool writeSyntheticSession(const SyntheticSession &session, const std::string &directory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Error: Could not create directory: " << directory << std::endl;
+        return false;
+    }
+
+    std::vector<uint16_t> words;
+    for (int i = 0; i < session.frames; ++i) {
+        generateSyntheticFrame(session, i, words);
+        std::string filename = (std::filesystem::path(directory) / syntheticFrameName(i)).string();
+        FILE *fp = fopen(filename.c_str(), "wb");
+        if (!fp) {
+            std::cerr << "Could not open file for writing: " << filename << std::endl;
+            return false;
+        }
+        bool ok = fwrite(words.data(), sizeof(uint16_t), words.size(), fp) == words.size();
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok) {
+            std::cerr << "Error: Could not write file: " << filename << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
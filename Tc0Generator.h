@@ -0,0 +1,43 @@
+#ifndef TC0GENERATOR_H
+#define TC0GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Deterministic synthetic recording: the same parameters always give the same bytes, so
+// benchmarks and checks run offline and reproducibly.
+// Every frame is a valid .tc0 (rows = 2 x height, cols = width, CV_16UC1): a YUYV test pattern
+// in the upper half and the temperature words in the lower half. The temperature is an ambient
+// gradient with noise plus, in the frames hotFirst..hotLast, a hot spot moving linearly from
+// (startX, startY) in the first frame to (endX, endY) in the last one.
+struct SyntheticSession {
+    int width = 256;            // thermal image width (cols)
+    int height = 192;           // thermal image height (rows / 2)
+    int frames = 100;
+    uint32_t seed = 1;
+    float ambient = 22.0f;      // Celsius
+    float noise = 0.5f;         // +- Celsius
+    float hotspotTemp = 80.0f;  // peak temperature of the hot spot
+    int hotspotRadius = 6;      // pixels
+    int startX = 128;           // hot spot trajectory
+    int startY = 96;
+    int endX = 128;
+    int endY = 96;
+    int hotFirst = 0;           // frames with the hot spot (hotLast < 0: up to the last frame)
+    int hotLast = -1;
+};
+
+// Function to parse "x0,y0,x1,y1" into the trajectory of the hot spot
+bool parseTrajectory(const std::string &text, SyntheticSession &session);
+
+// Function to generate the .tc0 words (header included) of frame `index`
+void generateSyntheticFrame(const SyntheticSession &session, int index, std::vector<uint16_t> &words);
+
+// Function to return the file name of frame `index` ("frame_000042.tc0"); sorted like the frames
+std::string syntheticFrameName(int index);
+
+// Function to write all frames of a session into a directory (created if missing)
+bool writeSyntheticSession(const SyntheticSession &session, const std::string &directory);
+
+#endif // TC0GENERATOR_H
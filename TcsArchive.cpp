@@ -0,0 +1,368 @@
+#include "TcsArchive.h"
+
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+
+const char ARCHIVE_MAGIC[8] = {'M', 'T', 'P', 'T', 'C', 'S', '\0', '\0'};
+const uint32_t ARCHIVE_VERSION = 1;
+const std::size_t FRAME_ALIGN = 64;
+
+// Largest valid .tc0 file: the 4 header words and 2 x 65535 x 32767 payload words
+const uint64_t MAX_RAW_SIZE = (4 + 2ULL * 65535 * 32767) * sizeof(uint16_t);
+
+struct ArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t indexOffset;
+    uint64_t stringBytes;
+    uint64_t reserved[4];
+};
+
+struct ArchiveRecord {
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t rawSize;
+    int64_t timestamp;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t codec;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ArchiveHeader) == 64, "ArchiveHeader layout");
+static_assert(sizeof(ArchiveRecord) == 48, "ArchiveRecord layout");
+
+// Function to delta code n words and split them into a low and a high byte plane:
+// neighbouring temperatures differ little, so the high plane is almost constant
+void encodePlanes(const uint8_t *data, std::size_t n, std::vector<uint8_t> &planes) {
+    planes.resize(n * 2);
+    uint16_t previous = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        uint16_t word;
+        std::memcpy(&word, data + i * 2, sizeof(word));
+        uint16_t delta = static_cast<uint16_t>(word - previous);
+        previous = word;
+        planes[i] = static_cast<uint8_t>(delta & 0xFF);
+        planes[n + i] = static_cast<uint8_t>(delta >> 8);
+    }
+}
+
+void decodePlanes(const uint8_t *planes, std::size_t n, uint16_t *words) {
+    uint16_t previous = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        previous = static_cast<uint16_t>(previous + (planes[i] | (planes[n + i] << 8)));
+        words[i] = previous;
+    }
+}
+
+// Function to check the raw size of a compressed frame before read() allocates it: a whole
+// number of words, no larger than a .tc0 can be, and within the range of zlib's lengths
+bool validDeflateRawSize(uint64_t rawSize) {
+    return rawSize % 2 == 0 && rawSize <= MAX_RAW_SIZE && rawSize <= std::numeric_limits<uLongf>::max();
+}
+
+} // namespace
+
+/* READER */
+
+TcsArchive::~TcsArchive() {
+    close();
+}
+
+void TcsArchive::close() {
+    if (map_) {
+        munmap(map_, mapSize_);
+        map_ = nullptr;
+        mapSize_ = 0;
+    }
+    frames_.clear();
+    byName_.clear();
+    path_.clear();
+}
+
+bool TcsArchive::open(const std::string &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot open archive: " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(ArchiveHeader)) {
+        std::cerr << "Error: Invalid archive (no header): " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    std::size_t fileSize = static_cast<std::size_t>(st.st_size);
+
+    void *map = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "Error: Cannot map archive: " << path << std::endl;
+        return false;
+    }
+    map_ = map;
+    mapSize_ = fileSize;
+    path_ = path;
+    const uint8_t *bytes = static_cast<const uint8_t *>(map_);
+
+    // Header, then the index at its end
+    ArchiveHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    uint64_t indexBytes = static_cast<uint64_t>(header.count) * sizeof(ArchiveRecord);
+    if (std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header.version != ARCHIVE_VERSION
+        || header.indexOffset > fileSize || indexBytes + header.stringBytes > fileSize - header.indexOffset) {
+        std::cerr << "Error: Invalid archive header: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    const uint8_t *names = bytes + header.indexOffset + indexBytes;
+    frames_.resize(header.count);
+    byName_.reserve(header.count);
+    for (uint32_t i = 0; i < header.count; ++i) {
+        ArchiveRecord r;
+        std::memcpy(&r, bytes + header.indexOffset + i * sizeof(ArchiveRecord), sizeof(r));
+        if (static_cast<uint64_t>(r.nameOffset) + r.nameLength > header.stringBytes
+            || r.offset > header.indexOffset || r.storedSize > header.indexOffset - r.offset
+            || (r.codec == CODEC_STORED && r.storedSize != r.rawSize) || r.codec > CODEC_DELTA_DEFLATE
+            || (r.codec == CODEC_DELTA_DEFLATE && !validDeflateRawSize(r.rawSize))) {
+            std::cerr << "Error: Invalid archive index entry " << i << ": " << path << std::endl;
+            close();
+            return false;
+        }
+        Frame &frame = frames_[i];
+        frame.name.assign(reinterpret_cast<const char *>(names) + r.nameOffset, r.nameLength);
+        if (!isSafeFrameName(frame.name)) {
+            std::cerr << "Error: Invalid frame name in archive index entry " << i << ": " << path << std::endl;
+            close();
+            return false;
+        }
+        frame.timestamp = r.timestamp;
+        frame.offset = r.offset;
+        frame.storedSize = r.storedSize;
+        frame.rawSize = r.rawSize;
+        frame.codec = r.codec;
+        byName_[frame.name] = i;
+    }
+
+    return true;
+}
+
+long TcsArchive::find(const std::string &name) const {
+    auto it = byName_.find(name);
+    return it == byName_.end() ? -1 : static_cast<long>(it->second);
+}
+
+const uint8_t *TcsArchive::storedData(std::size_t i) const {
+    if (frames_[i].codec != CODEC_STORED) {
+        return nullptr;
+    }
+    return static_cast<const uint8_t *>(map_) + frames_[i].offset;
+}
+
+bool TcsArchive::read(std::size_t i, std::vector<uint16_t> &words) const {
+    const Frame &frame = frames_[i];
+    const uint8_t *stored = static_cast<const uint8_t *>(map_) + frame.offset;
+    words.resize((frame.rawSize + 1) / 2);
+
+    if (frame.codec == CODEC_STORED) {
+        std::memcpy(words.data(), stored, frame.rawSize);
+        return true;
+    }
+
+    // Inflate the byte planes, then undo the delta coding
+    std::size_t n = frame.rawSize / 2;
+    thread_local std::vector<uint8_t> planes;
+    planes.resize(n * 2);
+    uLongf length = static_cast<uLongf>(planes.size());
+    if (uncompress(planes.data(), &length, stored, static_cast<uLong>(frame.storedSize)) != Z_OK || length != planes.size()) {
+        std::cerr << "Error: Corrupt frame " << frame.name << " in archive " << path_ << std::endl;
+        return false;
+    }
+    decodePlanes(planes.data(), n, words.data());
+    return true;
+}
+
+std::shared_ptr<const TcsArchive> TcsArchive::shared(const std::string &path) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<const TcsArchive>> archives;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = archives.find(path);
+    if (it != archives.end()) {
+        return it->second;
+    }
+
+    auto archive = std::make_shared<TcsArchive>();
+    if (!archive->open(path)) {
+        return nullptr;
+    }
+    archives[path] = archive;
+    return archive;
+}
+
+/* WRITER */
+
+TcsWriter::~TcsWriter() {
+    if (file_) {
+        fclose(file_);
+        std::remove(tmpPath_.c_str());
+    }
+}
+
+bool TcsWriter::writeBytes(const void *data, std::size_t size) {
+    if (fwrite(data, 1, size, file_) != size) {
+        std::cerr << "Error: Could not write archive: " << tmpPath_ << std::endl;
+        return false;
+    }
+    offset_ += size;
+    return true;
+}
+
+bool TcsWriter::create(const std::string &path, bool compress, int level) {
+    path_ = path;
+    tmpPath_ = path + ".tmp";
+    compress_ = compress;
+    level_ = level;
+    frames_.clear();
+    offset_ = 0;
+
+    file_ = fopen(tmpPath_.c_str(), "wb");
+    if (!file_) {
+        std::cerr << "Error: Could not create archive: " << tmpPath_ << std::endl;
+        return false;
+    }
+
+    // Placeholder, the header is written by finish() once the index position is known
+    ArchiveHeader header{};
+    return writeBytes(&header, sizeof(header));
+}
+
+bool TcsWriter::add(const std::string &name, int64_t timestamp, const uint8_t *data, std::size_t size) {
+    // Every frame starts on a 64-byte boundary (aligned rows when read from the mapping)
+    static const uint8_t padding[FRAME_ALIGN] = {};
+    if (!writeBytes(padding, (FRAME_ALIGN - offset_ % FRAME_ALIGN) % FRAME_ALIGN)) {
+        return false;
+    }
+
+    TcsArchive::Frame frame;
+    frame.name = name;
+    frame.timestamp = timestamp;
+    frame.offset = offset_;
+    frame.rawSize = size;
+    frame.codec = TcsArchive::CODEC_STORED;
+    const uint8_t *stored = data;
+    std::size_t storedSize = size;
+
+    if (compress_ && size % 2 == 0) {
+        encodePlanes(data, size / 2, planes_);
+        uLongf length = compressBound(static_cast<uLong>(planes_.size()));
+        compressed_.resize(length);
+        if (compress2(compressed_.data(), &length, planes_.data(), static_cast<uLong>(planes_.size()), level_) == Z_OK && length < size) {
+            frame.codec = TcsArchive::CODEC_DELTA_DEFLATE;
+            stored = compressed_.data();
+            storedSize = length;
+        }
+    }
+
+    frame.storedSize = storedSize;
+    if (!writeBytes(stored, storedSize)) {
+        return false;
+    }
+    frames_.push_back(frame);
+    return true;
+}
+
+bool TcsWriter::finish() {
+    std::vector<ArchiveRecord> records;
+    std::string names;
+    records.reserve(frames_.size());
+    for (const auto &frame : frames_) {
+        ArchiveRecord r{};
+        r.offset = frame.offset;
+        r.storedSize = frame.storedSize;
+        r.rawSize = frame.rawSize;
+        r.timestamp = frame.timestamp;
+        r.nameOffset = static_cast<uint32_t>(names.size());
+        r.nameLength = static_cast<uint32_t>(frame.name.size());
+        r.codec = frame.codec;
+        records.push_back(r);
+        names += frame.name;
+    }
+
+    static const uint8_t padding[8] = {};
+    if (!writeBytes(padding, (8 - offset_ % 8) % 8)) {
+        return false;
+    }
+
+    ArchiveHeader header{};
+    std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    header.version = ARCHIVE_VERSION;
+    header.count = static_cast<uint32_t>(records.size());
+    header.indexOffset = offset_;
+    header.stringBytes = names.size();
+
+    bool ok = writeBytes(records.data(), records.size() * sizeof(ArchiveRecord)) && writeBytes(names.data(), names.size());
+    ok = ok && fseek(file_, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file_) == 1;
+    ok = (fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    if (!ok) {
+        std::cerr << "Error: Could not write archive: " << tmpPath_ << std::endl;
+        std::remove(tmpPath_.c_str());
+        return false;
+    }
+
+    if (std::rename(tmpPath_.c_str(), path_.c_str()) != 0) {
+        std::cerr << "Error: Could not replace archive: " << path_ << std::endl;
+        std::remove(tmpPath_.c_str());
+        return false;
+    }
+    return true;
+}
+
+/* PATHS */
+
+bool isSafeFrameName(const std::string &name) {
+    return !name.empty() && name != "." && name != ".." && name.find('/') == std::string::npos && name.find('\0') == std::string::npos;
+}
+
+bool isArchivePath(const std::string &path) {
+    return path.size() > 4 && path.compare(path.size() - 4, 4, ".tcs") == 0;
+}
+
+std::string archiveMemberPath(const std::string &archive, const std::string &name) {
+    return archive + "#" + name;
+}
+
+bool splitArchiveMember(const std::string &path, std::string &archive, std::string &name) {
+    std::size_t hash = path.rfind(".tcs#");
+    if (hash == std::string::npos) {
+        return false;
+    }
+    archive = path.substr(0, hash + 4);
+    name = path.substr(hash + 5);
+    return true;
+}
+
+std::string memberFilePath(const std::string &path) {
+    std::string archive, name;
+    if (!splitArchiveMember(path, archive, name)) {
+        return path;
+    }
+    std::size_t slash = archive.find_last_of('/');
+    return slash == std::string::npos ? name : archive.substr(0, slash + 1) + name;
+}
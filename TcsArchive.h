@@ -0,0 +1,122 @@
+#ifndef TCSARCHIVE_H
+#define TCSARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Packed session archive (.tcs): all .tc0 frames of one recording in a single file.
+//
+// File layout (little endian): ArchiveHeader, the frames in session order (each starting on a
+// 64-byte boundary), count x ArchiveRecord (offset index), string table with the frame names.
+// A frame is either stored as is, so it is read straight from the mapping, or compressed:
+// its 16-bit words are delta coded, split into low/high byte planes and deflated. Every frame
+// is compressed on its own, so frame N is reached in O(1) through the index.
+//
+// A frame of an archive is addressed as "<archive>.tcs#<frame name>" wherever a .tc0 path is
+// accepted (Tc0File opens it from the archive).
+class TcsArchive {
+public:
+    enum Codec {
+        CODEC_STORED = 0,        // the .tc0 bytes
+        CODEC_DELTA_DEFLATE = 1  // delta coded words, byte planes, zlib
+    };
+
+    struct Frame {
+        std::string name;        // file name of the frame in the session directory
+        int64_t timestamp = 0;   // modification time of the frame file (ns since the epoch)
+        uint64_t offset = 0;     // position of the stored bytes in the archive
+        uint64_t storedSize = 0;
+        uint64_t rawSize = 0;    // size of the .tc0 file
+        uint32_t codec = CODEC_STORED;
+    };
+
+    TcsArchive() = default;
+    ~TcsArchive();
+    TcsArchive(const TcsArchive &) = delete;
+    TcsArchive &operator=(const TcsArchive &) = delete;
+
+    // Function to map an archive and read its index; prints the reason and returns false on error
+    bool open(const std::string &path);
+    void close();
+
+    std::size_t size() const { return frames_.size(); }
+    const Frame &frame(std::size_t i) const { return frames_[i]; }
+
+    // Function to look up a frame by name; returns -1 if the archive does not contain it
+    long find(const std::string &name) const;
+
+    // Function to return the .tc0 bytes of a stored frame straight from the mapping
+    // (nullptr for a compressed frame)
+    const uint8_t *storedData(std::size_t i) const;
+
+    // Function to decode frame i into its .tc0 words (the vector is reused)
+    bool read(std::size_t i, std::vector<uint16_t> &words) const;
+
+    // Function to return the archive from a process-wide cache (opened on first use);
+    // nullptr if it cannot be opened
+    static std::shared_ptr<const TcsArchive> shared(const std::string &path);
+
+private:
+    std::string path_;
+    void *map_ = nullptr;
+    std::size_t mapSize_ = 0;
+    std::vector<Frame> frames_;
+    std::unordered_map<std::string, std::size_t> byName_;
+};
+
+// Writes an archive frame by frame (to a temporary file that is renamed by finish())
+class TcsWriter {
+public:
+    TcsWriter() = default;
+    ~TcsWriter();
+    TcsWriter(const TcsWriter &) = delete;
+    TcsWriter &operator=(const TcsWriter &) = delete;
+
+    // Function to start a new archive; `compress` selects CODEC_DELTA_DEFLATE at zlib `level`
+    bool create(const std::string &path, bool compress, int level = 6);
+
+    // Function to append the .tc0 bytes of a frame (a frame that does not shrink is stored)
+    bool add(const std::string &name, int64_t timestamp, const uint8_t *data, std::size_t size);
+
+    // Function to write the index and the header and move the archive into place
+    bool finish();
+
+    const std::vector<TcsArchive::Frame> &frames() const { return frames_; }
+
+private:
+    bool writeBytes(const void *data, std::size_t size);
+
+    std::string path_;
+    std::string tmpPath_;
+    FILE *file_ = nullptr;
+    uint64_t offset_ = 0;
+    bool compress_ = false;
+    int level_ = 6;
+    std::vector<TcsArchive::Frame> frames_;
+    std::vector<uint8_t> planes_;      // delta coded byte planes of the frame being added
+    std::vector<uint8_t> compressed_;  // its deflated bytes
+};
+
+// Function to check that a frame name stored in an archive is a plain file name: not empty,
+// not "." or "..", no '/' and no NUL (so it cannot lead out of the directory it is unpacked to)
+bool isSafeFrameName(const std::string &name);
+
+// Function to check whether a path names an archive (.tcs extension)
+bool isArchivePath(const std::string &path);
+
+// Function to build the path of a frame inside an archive: "<archive>#<name>"
+std::string archiveMemberPath(const std::string &archive, const std::string &name);
+
+// Function to split "<archive>.tcs#<name>" into its parts; false for a plain file path
+bool splitArchiveMember(const std::string &path, std::string &archive, std::string &name);
+
+// Function to return the path a frame would have in an unpacked session next to the archive
+// ("dir/session.tcs#f.tc0" -> "dir/f.tc0"); a plain file path is returned unchanged
+std::string memberFilePath(const std::string &path);
+
+#endif // TCSARCHIVE_H
@@ -0,0 +1,312 @@
+#include "ThermalFrame.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define THERMALFRAME_X86 1
+#endif
+
+namespace {
+
+const std::size_t ROW_ALIGN_FLOATS = 8;  // 32 bytes
+const std::size_t BUFFER_ALIGN = 64;
+
+std::size_t alignedStride(int width) {
+    return (static_cast<std::size_t>(width) + ROW_ALIGN_FLOATS - 1) / ROW_ALIGN_FLOATS * ROW_ALIGN_FLOATS;
+}
+
+float *allocateFloats(std::size_t count) {
+    std::size_t bytes = (count * sizeof(float) + BUFFER_ALIGN - 1) / BUFFER_ALIGN * BUFFER_ALIGN;
+    void *p = std::aligned_alloc(BUFFER_ALIGN, bytes == 0 ? BUFFER_ALIGN : bytes);
+    if (!p) throw std::bad_alloc();
+    return static_cast<float *>(p);
+}
+
+// Scalar reference: the division by 64 is exact, so x * (1/64) gives the same bits
+void rawToCelsiusScalar(const uint16_t *src, float *dst, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        dst[i] = static_cast<float>(src[i]) / 64.0f - 273.15f;
+    }
+}
+
+void minMaxScalar(const float *src, std::size_t n, float &minTemp, float &maxTemp) {
+    for (std::size_t i = 0; i < n; ++i) {
+        minTemp = src[i] < minTemp ? src[i] : minTemp;
+        maxTemp = src[i] > maxTemp ? src[i] : maxTemp;
+    }
+}
+
+void quantizeRowScalar(const float *src, std::size_t n, uint16_t *out16, uint8_t *out8, uint8_t *outLin, float minTemp, float range) {
+    for (std::size_t j = 0; j < n; ++j) {
+        float temp = src[j];
+        if (out16) out16[j] = static_cast<uint16_t>(std::min(std::max(temp / 255.0f * 65535.0f, 0.0f), 65535.0f));
+        if (out8) out8[j] = static_cast<uint8_t>(std::min(std::max(temp * 2.0f, 0.0f), 255.0f));
+        if (outLin) outLin[j] = static_cast<uint8_t>(std::min(std::max((temp - minTemp) / range * 255.0f, 0.0f), 255.0f));
+    }
+}
+
+uint64_t rawSumScalar(const uint16_t *src, std::size_t n) {
+    uint64_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        sum += src[i];
+    }
+    return sum;
+}
+
+#ifdef THERMALFRAME_X86
+// 32-bit lanes: each adds n / 4 words, exact for any row (n < 2^18)
+__attribute__((target("sse2")))
+uint64_t rawSumSse2(const uint16_t *src, std::size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    std::size_t i = 0;
+    for (; i + 8 <= n && i < (std::size_t(1) << 18); i += 8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_unpacklo_epi16(raw, zero), _mm_unpackhi_epi16(raw, zero)));
+    }
+    alignas(16) uint32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    return static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3] + rawSumScalar(src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void rawToCelsiusAvx2(const uint16_t *src, float *dst, std::size_t n) {
+    const __m256 scale = _mm256_set1_ps(1.0f / 64.0f);
+    const __m256 offset = _mm256_set1_ps(273.15f);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(raw));
+        __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(raw, 1));
+        _mm256_storeu_ps(dst + i, _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale), offset));
+        _mm256_storeu_ps(dst + i + 8, _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale), offset));
+    }
+    rawToCelsiusScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void rawToCelsiusSse2(const uint16_t *src, float *dst, std::size_t n) {
+    const __m128 scale = _mm_set1_ps(1.0f / 64.0f);
+    const __m128 offset = _mm_set1_ps(273.15f);
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i lo = _mm_unpacklo_epi16(raw, zero);
+        __m128i hi = _mm_unpackhi_epi16(raw, zero);
+        _mm_storeu_ps(dst + i, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), scale), offset));
+        _mm_storeu_ps(dst + i + 4, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), scale), offset));
+    }
+    rawToCelsiusScalar(src + i, dst + i, n - i);
+}
+
+// Function to truncate 8 floats in [0, 65535] to uint16 (SSE2 has no unsigned 32->16 pack)
+__attribute__((target("sse2")))
+inline __m128i packToU16(__m128 a, __m128 b) {
+    const __m128i bias = _mm_set1_epi32(32768);
+    __m128i ia = _mm_sub_epi32(_mm_cvttps_epi32(a), bias);
+    __m128i ib = _mm_sub_epi32(_mm_cvttps_epi32(b), bias);
+    return _mm_xor_si128(_mm_packs_epi32(ia, ib), _mm_set1_epi16(static_cast<short>(0x8000)));
+}
+
+// Function to truncate 16 floats in [0, 255] to uint8
+__attribute__((target("sse2")))
+inline __m128i packToU8(__m128 a, __m128 b, __m128 c, __m128 d) {
+    __m128i lo = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+    __m128i hi = _mm_packs_epi32(_mm_cvttps_epi32(c), _mm_cvttps_epi32(d));
+    return _mm_packus_epi16(lo, hi);
+}
+
+__attribute__((target("sse2")))
+void quantizeRowSse2(const float *src, std::size_t n, uint16_t *out16, uint8_t *out8, uint8_t *outLin, float minTemp, float range) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 c255 = _mm_set1_ps(255.0f);
+    const __m128 c65535 = _mm_set1_ps(65535.0f);
+    const __m128 c2 = _mm_set1_ps(2.0f);
+    const __m128 vmin = _mm_set1_ps(minTemp);
+    const __m128 vrange = _mm_set1_ps(range);
+    std::size_t j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m128 t[4];
+        for (int k = 0; k < 4; ++k) t[k] = _mm_loadu_ps(src + j + 4 * k);
+        if (out16) {
+            __m128 v[4];
+            for (int k = 0; k < 4; ++k) {
+                v[k] = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_div_ps(t[k], c255), c65535), zero), c65535);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out16 + j), packToU16(v[0], v[1]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out16 + j + 8), packToU16(v[2], v[3]));
+        }
+        if (out8) {
+            __m128 v[4];
+            for (int k = 0; k < 4; ++k) {
+                v[k] = _mm_min_ps(_mm_max_ps(_mm_mul_ps(t[k], c2), zero), c255);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out8 + j), packToU8(v[0], v[1], v[2], v[3]));
+        }
+        if (outLin) {
+            __m128 v[4];
+            for (int k = 0; k < 4; ++k) {
+                v[k] = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_div_ps(_mm_sub_ps(t[k], vmin), vrange), c255), zero), c255);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(outLin + j), packToU8(v[0], v[1], v[2], v[3]));
+        }
+    }
+    quantizeRowScalar(src + j, n - j, out16 ? out16 + j : nullptr, out8 ? out8 + j : nullptr,
+                      outLin ? outLin + j : nullptr, minTemp, range);
+}
+
+__attribute__((target("avx2")))
+void minMaxAvx2(const ThermalFrame &frame, float &minTemp, float &maxTemp) {
+    __m256 vmin = _mm256_set1_ps(minTemp);
+    __m256 vmax = _mm256_set1_ps(maxTemp);
+    std::size_t width = static_cast<std::size_t>(frame.width());
+    for (int y = 0; y < frame.height(); ++y) {
+        const float *row = frame.row(y);
+        std::size_t i = 0;
+        for (; i + 8 <= width; i += 8) {
+            __m256 v = _mm256_load_ps(row + i);
+            vmin = _mm256_min_ps(vmin, v);
+            vmax = _mm256_max_ps(vmax, v);
+        }
+        minMaxScalar(row + i, width - i, minTemp, maxTemp);
+    }
+    alignas(32) float lanes[16];
+    _mm256_store_ps(lanes, vmin);
+    _mm256_store_ps(lanes + 8, vmax);
+    for (int k = 0; k < 8; ++k) {
+        minTemp = lanes[k] < minTemp ? lanes[k] : minTemp;
+        maxTemp = lanes[8 + k] > maxTemp ? lanes[8 + k] : maxTemp;
+    }
+}
+
+__attribute__((target("sse2")))
+void minMaxSse2(const ThermalFrame &frame, float &minTemp, float &maxTemp) {
+    __m128 vmin = _mm_set1_ps(minTemp);
+    __m128 vmax = _mm_set1_ps(maxTemp);
+    std::size_t width = static_cast<std::size_t>(frame.width());
+    for (int y = 0; y < frame.height(); ++y) {
+        const float *row = frame.row(y);
+        std::size_t i = 0;
+        for (; i + 4 <= width; i += 4) {
+            __m128 v = _mm_load_ps(row + i);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+        }
+        minMaxScalar(row + i, width - i, minTemp, maxTemp);
+    }
+    alignas(16) float lanes[8];
+    _mm_store_ps(lanes, vmin);
+    _mm_store_ps(lanes + 4, vmax);
+    for (int k = 0; k < 4; ++k) {
+        minTemp = lanes[k] < minTemp ? lanes[k] : minTemp;
+        maxTemp = lanes[4 + k] > maxTemp ? lanes[4 + k] : maxTemp;
+    }
+}
+#endif
+
+} // namespace
+
+ThermalFrame::ThermalFrame(int width, int height) {
+    resize(width, height);
+}
+
+ThermalFrame::~ThermalFrame() {
+    std::free(data_);
+}
+
+ThermalFrame::ThermalFrame(const ThermalFrame &other) {
+    *this = other;
+}
+
+ThermalFrame &ThermalFrame::operator=(const ThermalFrame &other) {
+    if (this != &other) {
+        resize(other.width_, other.height_);
+        if (!empty()) {
+            std::memcpy(data_, other.data_, stride_ * height_ * sizeof(float));
+        }
+    }
+    return *this;
+}
+
+ThermalFrame::ThermalFrame(ThermalFrame &&other) noexcept {
+    *this = std::move(other);
+}
+
+ThermalFrame &ThermalFrame::operator=(ThermalFrame &&other) noexcept {
+    if (this != &other) {
+        std::free(data_);
+        data_ = std::exchange(other.data_, nullptr);
+        capacity_ = std::exchange(other.capacity_, 0);
+        stride_ = std::exchange(other.stride_, 0);
+        width_ = std::exchange(other.width_, 0);
+        height_ = std::exchange(other.height_, 0);
+    }
+    return *this;
+}
+
+void ThermalFrame::resize(int width, int height) {
+    std::size_t stride = alignedStride(width);
+    std::size_t needed = stride * static_cast<std::size_t>(height);
+    if (needed > capacity_) {
+        std::free(data_);
+        data_ = nullptr;
+        data_ = allocateFloats(needed);
+        capacity_ = needed;
+    }
+    stride_ = stride;
+    width_ = width;
+    height_ = height;
+}
+
+void rawToCelsius(const uint16_t *src, float *dst, std::size_t n) {
+#ifdef THERMALFRAME_X86
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2) {
+        rawToCelsiusAvx2(src, dst, n);
+    } else {
+        rawToCelsiusSse2(src, dst, n);
+    }
+#else
+    rawToCelsiusScalar(src, dst, n);
+#endif
+}
+
+uint64_t rawSum(const uint16_t *src, std::size_t n) {
+#ifdef THERMALFRAME_X86
+    return rawSumSse2(src, n);
+#else
+    return rawSumScalar(src, n);
+#endif
+}
+
+void temperatureMinMax(const ThermalFrame &frame, float &minTemp, float &maxTemp) {
+    minTemp = std::numeric_limits<float>::infinity();
+    maxTemp = -std::numeric_limits<float>::infinity();
+#ifdef THERMALFRAME_X86
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2) {
+        minMaxAvx2(frame, minTemp, maxTemp);
+    } else {
+        minMaxSse2(frame, minTemp, maxTemp);
+    }
+#else
+    for (int y = 0; y < frame.height(); ++y) {
+        minMaxScalar(frame.row(y), static_cast<std::size_t>(frame.width()), minTemp, maxTemp);
+    }
+#endif
+}
+
+void quantizeRow(const float *src, std::size_t n, uint16_t *out16, uint8_t *out8, uint8_t *outLin, float minTemp, float range) {
+#ifdef THERMALFRAME_X86
+    quantizeRowSse2(src, n, out16, out8, outLin, minTemp, range);
+#else
+    quantizeRowScalar(src, n, out16, out8, outLin, minTemp, range);
+#endif
+}
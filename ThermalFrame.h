@@ -0,0 +1,59 @@
+#ifndef THERMALFRAME_H
+#define THERMALFRAME_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Temperature frame in Celsius stored as one aligned, contiguous row-major buffer.
+// Every row starts on a 32-byte boundary: stride() >= width() floats.
+class ThermalFrame {
+public:
+    ThermalFrame() = default;
+    ThermalFrame(int width, int height);
+    ~ThermalFrame();
+    ThermalFrame(const ThermalFrame &other);
+    ThermalFrame &operator=(const ThermalFrame &other);
+    ThermalFrame(ThermalFrame &&other) noexcept;
+    ThermalFrame &operator=(ThermalFrame &&other) noexcept;
+
+    // Function to change the frame size; the buffer is only reallocated when it grows
+    void resize(int width, int height);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    std::size_t stride() const { return stride_; }  // in floats
+    bool empty() const { return width_ == 0 || height_ == 0; }
+    std::size_t capacity() const { return capacity_; }  // allocated floats
+
+    float *row(int y) { return data_ + static_cast<std::size_t>(y) * stride_; }
+    const float *row(int y) const { return data_ + static_cast<std::size_t>(y) * stride_; }
+    float &at(int y, int x) { return row(y)[x]; }
+    float at(int y, int x) const { return row(y)[x]; }
+
+private:
+    float *data_ = nullptr;
+    std::size_t capacity_ = 0;  // in floats
+    std::size_t stride_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+// Function to convert n raw temperature words to Celsius: t = x / 64 - 273.15.
+// Uses AVX2 or SSE2 when the CPU supports it; the result is bit-exact with the scalar formula.
+void rawToCelsius(const uint16_t *src, float *dst, std::size_t n);
+
+// Function to add up n raw words exactly (SSE2 where available)
+uint64_t rawSum(const uint16_t *src, std::size_t n);
+
+// Function to find the minimum and maximum temperature of a frame (vectorized like rawToCelsius).
+// An empty frame gives min = +inf and max = -inf.
+void temperatureMinMax(const ThermalFrame &frame, float &minTemp, float &maxTemp);
+
+// Function to quantize n temperatures into image pixels; a null output pointer skips that image.
+//   out16:  t / 255 * 65535 clamped to 0-65535
+//   out8:   t * 2 clamped to 0-255
+//   outLin: (t - minTemp) / range * 255 clamped to 0-255
+// SSE2 where available; bit-exact with the scalar expressions above.
+void quantizeRow(const float *src, std::size_t n, uint16_t *out16, uint8_t *out8, uint8_t *outLin, float minTemp, float range);
+
+#endif // THERMALFRAME_H
@@ -0,0 +1,376 @@
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <cmath>
+#include <random>
+
+#include "ConfigReader.h"
+#include "FrameProcessor.h"
+#include "FramePool.h"
+#include "ParallelFor.h"
+#include "Tc0Generator.h"
+#include "FalseColor.h"
+
+// mtpBench: microbenchmarks of every stage of the frame pipeline on a synthetic session,
+// printed as JSON (one object) so that runs can be compared between versions.
+//   mtpBench [--size WxH] [--frames N] [--iterations N] [--dir DIR] [--series PATH] [--keep]
+//   mtpBench generate <directory> [--size WxH] [--frames N] [--seed S] [--path x0,y0,x1,y1] [--hot A-B]
+//   mtpBench check   (self-check of the fast paths against the reference ones; exit code 1 on a mismatch)
+
+// Timing of one stage: total time of every pass over the frames
+struct StageTiming {
+    std::string name;
+    std::vector<double> passSeconds;
+    size_t itemsPerPass = 0;
+};
+
+// Function to run `fn` on every frame index, `iterations` times, and record each pass
+StageTiming timeStage(const std::string &name, int iterations, size_t frames, const std::function<void(size_t)> &fn) {
+    StageTiming timing;
+    timing.name = name;
+    timing.itemsPerPass = frames;
+    for (int pass = 0; pass < iterations; ++pass) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames; ++i) {
+            fn(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        timing.passSeconds.push_back(std::chrono::duration<double>(end - start).count());
+    }
+    return timing;
+}
+
+// Function to print a stage as a JSON object: per-frame time of the fastest and the median pass
+void printStage(const StageTiming &timing, bool last) {
+    std::vector<double> sorted = timing.passSeconds;
+    std::sort(sorted.begin(), sorted.end());
+    double items = static_cast<double>(std::max<size_t>(timing.itemsPerPass, 1));
+    double minNs = sorted.front() / items * 1e9;
+    double medianNs = sorted[sorted.size() / 2] / items * 1e9;
+    std::printf("    \"%s\": {\"ns_per_frame_min\": %.1f, \"ns_per_frame_median\": %.1f, \"frames_per_s\": %.1f}%s\n",
+                timing.name.c_str(), minNs, medianNs, medianNs > 0.0 ? 1e9 / medianNs : 0.0, last ? "" : ",");
+}
+
+// Function to parse "WxH"
+bool parseSize(const std::string &text, SyntheticSession &session) {
+    size_t x = text.find('x');
+    if (x == std::string::npos) return false;
+    try {
+        session.width = std::stoi(text.substr(0, x));
+        session.height = std::stoi(text.substr(x + 1));
+    } catch (const std::exception &e) {
+        return false;
+    }
+    return session.width > 0 && session.height > 0 && session.width <= 65535 && session.height <= 32767;
+}
+
+// Function to parse the options shared by both modes; unknown arguments are left in `rest`
+bool parseSessionOptions(const std::vector<std::string> &args, SyntheticSession &session, std::vector<std::string> &rest) {
+    try {
+        for (size_t i = 0; i < args.size(); ++i) {
+            bool hasValue = i + 1 < args.size();
+            if (args[i] == "--size" && hasValue) {
+                if (!parseSize(args[++i], session)) return false;
+            } else if (args[i] == "--frames" && hasValue) {
+                session.frames = std::stoi(args[++i]);
+                if (session.frames < 1) return false;
+            } else if (args[i] == "--seed" && hasValue) {
+                session.seed = static_cast<uint32_t>(std::stoul(args[++i]));
+            } else if (args[i] == "--path" && hasValue) {
+                if (!parseTrajectory(args[++i], session)) return false;
+            } else if (args[i] == "--hot" && hasValue) {
+                std::string range = args[++i];
+                size_t dash = range.find('-');
+                if (dash == std::string::npos) return false;
+                session.hotFirst = std::stoi(range.substr(0, dash));
+                session.hotLast = std::stoi(range.substr(dash + 1));
+            } else {
+                rest.push_back(args[i]);
+            }
+        }
+    } catch (const std::exception &e) {
+        return false;
+    }
+    return true;
+}
+
+// Function to check classifyHotspotRaw against the float verdict of calculateHotspotAverage on
+// squares whose raw sum sweeps across the bound of each threshold; returns the number of mismatches
+size_t checkRawClassification() {
+    const int cols = 32;
+    const int rows = 2 * 32;
+    std::vector<uint16_t> words(static_cast<size_t>(cols) * (rows / 2));
+    RawSpan temperature(words);
+
+    // Round thresholds, their float neighbours, the extremes and random ones
+    std::vector<float> thresholds = {35.0f, 0.0f, -273.15f, 20.005f, 100.0f, 700.0f};
+    for (float t : {35.0f, 0.0f, 36.6f}) {
+        thresholds.push_back(std::nextafter(t, 1000.0f));
+        thresholds.push_back(std::nextafter(t, -1000.0f));
+    }
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> anyThreshold(-100.0f, 700.0f);
+    for (int i = 0; i < 20; ++i) {
+        thresholds.push_back(anyThreshold(random));
+    }
+
+    // Squares inside the frame and clipped by its edge: {x, y, size}
+    const int squares[][3] = {{3, 3, 1}, {3, 3, 2}, {5, 5, 3}, {10, 4, 11}, {8, 8, 16}, {26, 28, 11}};
+
+    size_t cases = 0, undecided = 0, mismatches = 0;
+    for (float threshold : thresholds) {
+        for (const auto &square : squares) {
+            Config config = Config();
+            config.hotspot_x = square[0];
+            config.hotspot_y = square[1];
+            config.hotspot_size = square[2];
+            config.hotspot_temp_threshold = threshold;
+            config.hotspot_raw_bound = rawSumBound(threshold, square[2] * square[2]);
+            int x1 = std::min(square[0] + square[2], cols);
+            int y1 = std::min(square[1] + square[2], rows / 2);
+            int64_t count = static_cast<int64_t>(x1 - square[0]) * (y1 - square[1]);
+            RawSumBound bound = rawSumBound(threshold, static_cast<int>(count));
+
+            // Every sum across the undecided band plus a margin, spread evenly or unevenly
+            int64_t exact = std::llround(64.0 * count * (threshold + static_cast<double>(273.15f)));
+            int64_t first = std::min(bound.below, exact) - 64;
+            int64_t last = std::max(bound.above, exact) + 64;
+            for (int64_t sum = std::max<int64_t>(first, 0); sum <= std::min<int64_t>(last, 65535 * count); ++sum) {
+                for (int spread : {0, 700, 20000}) {
+                    // Even split of the sum, then pairs of pixels moved +spread/-spread (same sum)
+                    std::vector<int64_t> values(static_cast<size_t>(count), sum / count);
+                    for (int64_t k = 0; k < sum % count; ++k) {
+                        ++values[k];
+                    }
+                    for (int64_t k = 0; k + 1 < count; k += 2) {
+                        if (values[k] + spread <= 65535 && values[k + 1] - spread >= 0) {
+                            values[k] += spread;
+                            values[k + 1] -= spread;
+                        }
+                    }
+                    std::fill(words.begin(), words.end(), 0);
+                    size_t k = 0;
+                    for (int y = square[1]; y < y1; ++y) {
+                        for (int x = square[0]; x < x1; ++x) {
+                            words[static_cast<size_t>(y) * cols + x] = static_cast<uint16_t>(values[k++]);
+                        }
+                    }
+
+                    int expected = calculateHotspotAverage(temperature, rows, cols, config) >= threshold ? 1 : 0;
+                    int verdict = classifyHotspotRaw(temperature, rows, cols, config);
+                    ++cases;
+                    undecided += sum >= bound.below && sum < bound.above;
+                    if (verdict != expected) {
+                        if (++mismatches <= 10) {
+                            std::fprintf(stderr, "raw_classify mismatch: threshold %.9g square %d,%d,%d sum %lld: raw %d, float %d\n",
+                                         threshold, square[0], square[1], square[2], static_cast<long long>(sum), verdict, expected);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    std::printf("raw_classify: %zu cases, %zu in the float band, %zu mismatches\n", cases, undecided, mismatches);
+    return mismatches;
+}
+
+void printUsage(const char *program) {
+    std::cerr << "Usage: " << program << " [--size WxH] [--frames N] [--iterations N] [--dir DIR] [--series PATH] [--keep]" << std::endl;
+    std::cerr << "       " << program << " generate <directory> [--size WxH] [--frames N] [--seed S] [--path x0,y0,x1,y1] [--hot A-B]" << std::endl;
+    std::cerr << "       " << program << " check" << std::endl;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.size() == 1 && args[0] == "check") {
+        return checkRawClassification() == 0 ? 0 : 1;
+    }
+    bool generateOnly = !args.empty() && args[0] == "generate";
+    if (generateOnly) {
+        args.erase(args.begin());
+    }
+
+    // Read configuration data; the hot spot moves through the configured hot spot square
+    Config config = readConfig("config.txt");
+    SyntheticSession session;
+    session.frames = 50;
+    session.startX = config.hotspot_x + config.hotspot_size / 2 - 8;
+    session.startY = config.hotspot_y + config.hotspot_size / 2;
+    session.endX = session.startX + 16;
+    session.endY = session.startY;
+
+    std::vector<std::string> rest;
+    if (!parseSessionOptions(args, session, rest)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (generateOnly) {
+        if (rest.size() != 1) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return writeSyntheticSession(session, rest[0]) ? 0 : 1;
+    }
+
+    int iterations = 5;
+    bool keep = false;
+    std::string directory = (std::filesystem::temp_directory_path() / "mtpBench").string();
+    std::string seriesPath = "./bin/mtpSeries";
+    for (size_t i = 0; i < rest.size(); ++i) {
+        bool hasValue = i + 1 < rest.size();
+        if (rest[i] == "--iterations" && hasValue) {
+            iterations = std::max(std::atoi(rest[++i].c_str()), 1);
+        } else if (rest[i] == "--dir" && hasValue) {
+            directory = rest[++i];
+        } else if (rest[i] == "--series" && hasValue) {
+            seriesPath = rest[++i];
+        } else if (rest[i] == "--keep") {
+            keep = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Synthetic session on disk, plus the decoded inputs of every stage kept in memory
+    if (!writeSyntheticSession(session, directory)) {
+        return 1;
+    }
+    std::string outputDirectory = (std::filesystem::path(directory) / "out").string();
+    std::filesystem::create_directories(outputDirectory);
+    std::string outputBase = (std::filesystem::path(outputDirectory) / "bench").string();
+
+    const size_t frames = static_cast<size_t>(session.frames);
+    const int rows = 2 * session.height;
+    const int cols = session.width;
+    const size_t pixels = static_cast<size_t>(session.height) * cols;
+    std::vector<std::string> files(frames);
+    std::vector<std::vector<uint16_t>> words(frames);
+    std::vector<ThermalFrame> temperatures(frames);
+    std::vector<TemperatureImages> images(frames);
+    auto imageHalf = [&](size_t i) { return RawSpan(words[i].data() + 4, pixels); };
+    auto temperatureHalf = [&](size_t i) { return RawSpan(words[i].data() + 4 + pixels, pixels); };
+    for (size_t i = 0; i < frames; ++i) {
+        files[i] = (std::filesystem::path(directory) / syntheticFrameName(static_cast<int>(i))).string();
+        generateSyntheticFrame(session, static_cast<int>(i), words[i]);
+        convertToTemperature(temperatureHalf(i), rows, cols, temperatures[i]);
+        quantizeTemperatureFrame(temperatures[i], IMAGE_ALL, images[i]);
+        drawFrames(images[i].img_lin, config);
+    }
+
+    // Reused buffers, as in a batch run
+    std::vector<uint16_t> imageData, temperatureData;
+    int loadedRows, loadedCols;
+    ThermalFrame frame;
+    TemperatureImages quantized;
+    PngBuffers png;
+    PngOptions pngOptions = pngOptionsFromConfig(config);
+    std::string text;
+    cv::Mat bgr;
+    std::vector<uint8_t> jpeg;
+    FramePool pool;
+    volatile float sink = 0.0f;
+
+    std::vector<StageTiming> stages;
+    stages.push_back(timeStage("load", iterations, frames, [&](size_t i) {
+        loadDataFromFile(files[i], imageData, temperatureData, loadedRows, loadedCols);
+    }));
+    stages.push_back(timeStage("convert", iterations, frames, [&](size_t i) {
+        convertToTemperature(temperatureHalf(i), rows, cols, frame);
+    }));
+    stages.push_back(timeStage("minmax", iterations, frames, [&](size_t i) {
+        float minTemp, maxTemp;
+        temperatureMinMax(temperatures[i], minTemp, maxTemp);
+        sink = sink + minTemp + maxTemp;
+    }));
+    stages.push_back(timeStage("quantize", iterations, frames, [&](size_t i) {
+        quantizeTemperatureFrame(temperatures[i], IMAGE_ALL, quantized);
+    }));
+    stages.push_back(timeStage("png_16bit", iterations, frames, [&](size_t i) {
+        saveImageWithMetadata(outputBase + "_16bit.png", images[i].img_16bit, "Temperature Range: 0-256", 16, pngOptions, png);
+    }));
+    stages.push_back(timeStage("png_8bit", iterations, frames, [&](size_t i) {
+        saveImageWithMetadata(outputBase + "_8bit.png", images[i].img_8bit, "Temperature Range: 0-128", 8, pngOptions, png);
+    }));
+    stages.push_back(timeStage("png_lin", iterations, frames, [&](size_t i) {
+        saveImageWithMetadata(outputBase + "_lin.png", images[i].img_lin, "Min: 0 Max: 0", 8, pngOptions, png);
+    }));
+    stages.push_back(timeStage("csv", iterations, frames, [&](size_t i) {
+        saveTemperatureMatrixToFile(temperatures[i], outputBase, text);
+    }));
+    stages.push_back(timeStage("yuyv_jpg", iterations, frames, [&](size_t i) {
+        convertImageDataToImage(imageHalf(i), rows, cols, outputBase, config.jpg_quality, bgr, jpeg);
+    }));
+    // Session video: false colour through the raw word table, overlays and the encoder (25 fps real time = 40 ms per frame)
+    FalseColorLut lut;
+    lut.build(20.0f, 80.0f);
+    cv::Mat colored;
+    stages.push_back(timeStage("false_color", iterations, frames, [&](size_t i) {
+        lut.apply(temperatureHalf(i), rows, cols, colored);
+    }));
+    cv::VideoWriter writer(outputBase + ".avi", cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 25.0, cv::Size(cols, rows / 2), true);
+    stages.push_back(timeStage("video_frame", iterations, frames, [&](size_t i) {
+        lut.apply(temperatureHalf(i), rows, cols, colored);
+        drawFrames(colored, config);
+        writer.write(colored);
+    }));
+    writer.release();
+    stages.push_back(timeStage("hotspot", iterations, frames, [&](size_t i) {
+        sink = sink + calculateHotspotAverage(temperatures[i], config);
+    }));
+    stages.push_back(timeStage("hotspot_raw", iterations, frames, [&](size_t i) {
+        sink = sink + calculateHotspotAverage(temperatureHalf(i), rows, cols, config);
+    }));
+    HotspotTracker tracker;
+    stages.push_back(timeStage("hotspot_locate", iterations, frames, [&](size_t i) {
+        sink = sink + tracker.locate(temperatureHalf(i), rows, cols, config).mean;
+    }));
+    stages.push_back(timeStage("frame_stats", iterations, frames, [&](size_t i) {
+        sink = sink + calculateFrameStats(temperatureHalf(i), rows, cols, config).maxTemp;
+    }));
+    stages.push_back(timeStage("process_frame", iterations, frames, [&](size_t i) {
+        processFrame(files[i], config, OUTPUT_ALL, nullptr, &pool);
+    }));
+
+    // End to end: the mtpSeries binary classifying the whole session (no index), per frame
+    bool haveSeries = std::filesystem::exists(seriesPath);
+    StageTiming series;
+    if (haveSeries) {
+        std::string command = seriesPath + " " + directory + " --no-index > /dev/null";
+        series = timeStage("mtpSeries", iterations, 1, [&](size_t) {
+            if (std::system(command.c_str()) != 0) haveSeries = false;
+        });
+        series.itemsPerPass = frames;
+    }
+
+    // JSON report
+    std::printf("{\n");
+    std::printf("  \"version\": 1,\n");
+    std::printf("  \"width\": %d, \"height\": %d, \"frames\": %d, \"iterations\": %d, \"hardware_threads\": %d,\n",
+                session.width, session.height, session.frames, iterations, hardwareJobs());
+    std::printf("  \"compiler\": \"%s\",\n", __VERSION__);
+    std::printf("  \"stages\": {\n");
+    for (size_t i = 0; i < stages.size(); ++i) {
+        printStage(stages[i], i + 1 == stages.size() && !haveSeries);
+    }
+    if (haveSeries) {
+        printStage(series, true);
+    }
+    std::printf("  },\n");
+    std::printf("  \"pool_allocations\": %zu\n", pool.allocations());
+    std::printf("}\n");
+
+    if (!keep) {
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+    return 0;
+}
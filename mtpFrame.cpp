@@ -1,17 +1,18 @@
 #include <iostream>
 #include <fstream>
-#include <vector>
-#include <algorithm>
-#include <cstdint>
-#include <limits>
-#include <opencv2/opencv.hpp>  // OpenCV library for image processing
-#include <png.h>
 #include <string>
-#include <iomanip> // for std::setprecision
-#include <sstream>
-#include <map>
+#include <vector>
+#include <cstdio>
 
 #include "ConfigReader.h"
+#include "FrameProcessor.h"
+#include "FramePool.h"
+#include "FramePipeline.h"
+#include "ParallelFor.h"
+#include "TcsArchive.h"
+#include "Stats.h"
+
+#define PIPELINE_DEPTH 4  // batch: frames read ahead of the workers
 
 // // Struct to hold configuration data
 // struct Config {
@@ -61,333 +62,155 @@
 //     return config;
 // }
 
-// Function to load raw data from the file and split it into image and temperature matrices
-bool loadDataFromFile(const std::string &filename, std::vector<uint16_t> &imageData, std::vector<uint16_t> &temperatureData, int &rows, int &cols) {
-    // Open the binary file
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        std::cerr << "Cannot open file." << std::endl;
-        return false;
-    }
-
-    // Read the entire file as uint16_t (2 bytes)
-    std::vector<uint16_t> val;
-    uint16_t temp;
-    while (file.read(reinterpret_cast<char*>(&temp), sizeof(uint16_t))) {
-        val.push_back(temp);
+// Function to append the non-empty lines of a file list (one path per line) to `inputs`
+void readFileList(std::istream &in, std::vector<std::string> &inputs) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) inputs.push_back(line);
     }
-    file.close();
-
-    // Read the headers (rows, cols, type, channels)
-    rows = val[0];    // Number of rows in the matrix
-    cols = val[1];    // Number of columns in the matrix
-    //int type = val[2];  // Data type (not used here)
-    //int chan = val[3];  // Number of channels (not used here)
-
-    // Split the data into image (upper half) and temperature (lower half)
-    imageData.assign(val.begin() + 4, val.begin() + 4 + (rows / 2) * cols);  // Upper half of the data
-    temperatureData.assign(val.begin() + 4 + (rows / 2) * cols, val.end());  // Lower half of the data
-
-    return true;
 }
 
-// Function to convert raw temperature data to a temperature matrix in Celsius
-std::vector<std::vector<float>> convertToTemperature(const std::vector<uint16_t> &temperatureData, int rows, int cols) {
-    std::vector<std::vector<float>> temperatureMatrix(rows / 2, std::vector<float>(cols));
-
-    // Convert each value using the formula: t = x / 64 - 273.15
-    for (int i = 0; i < rows / 2; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            temperatureMatrix[i][j] = static_cast<float>(temperatureData[i * cols + j]) / 64.0f - 273.15f;
-        }
+// Function to add all frames of a .tcs archive to `inputs`, in session order
+bool addArchiveFrames(const std::string &archivePath, std::vector<std::string> &inputs) {
+    auto archive = TcsArchive::shared(archivePath);
+    if (!archive) {
+        return false;
     }
-
-    return temperatureMatrix;
+    for (size_t i = 0; i < archive->size(); ++i) {
+        inputs.push_back(archiveMemberPath(archivePath, archive->frame(i).name));
+    }
+    return true;
 }
 
-// Function to save a 16-bit or 8-bit PNG image with metadata
-void saveImageWithMetadata(const std::string &filename, const cv::Mat &image, const std::string &metadata, int depth) {
-    FILE *fp = fopen(filename.c_str(), "wb");
-    if (!fp) {
-        std::cerr << "Could not open file for writing: " << filename << std::endl;
-        return;
+// Function to print the batch result line of a frame: <file>\t<verdict>\t<hotspot mean>[\t<rois>][\t<hotspot>]
+// (verdict -1 and mean "nan" when the frame could not be processed; the located hot spot in auto mode)
+void printBatchResult(const std::string &filename, int result, float hotspotMean, const std::vector<RoiResult> &rois,
+                      const HotspotLocation *hotspot) {
+    char mean[32] = "nan";
+    if (result >= 0) {
+        std::snprintf(mean, sizeof(mean), "%.2f", hotspotMean);
     }
-
-    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
-    if (!png) {
-        fclose(fp);
-        return;
+    std::cout << filename << "\t" << result << "\t" << mean;
+    if (result >= 0 && !rois.empty()) {
+        std::cout << "\t" << formatRoiResults(rois);
     }
-
-    png_infop info = png_create_info_struct(png);
-    if (!info) {
-        png_destroy_write_struct(&png, nullptr);
-        fclose(fp);
-        return;
+    if (result >= 0 && hotspot) {
+        std::cout << "\t" << formatHotspotLocation(*hotspot);
     }
+    std::cout << "\n";
+}
 
-    if (setjmp(png_jmpbuf(png))) {
-        png_destroy_write_struct(&png, &info);
-        fclose(fp);
-        return;
-    }
-
-    png_init_io(png, fp);
-
-    // Set the PNG metadata
-    png_text text;
-    text.compression = PNG_TEXT_COMPRESSION_NONE;
-    text.key = const_cast<char*>("Description");
-    text.text = const_cast<char*>(metadata.c_str());
-    text.text_length = metadata.length();
-    png_set_text(png, info, &text, 1);
+int main(int argc, char *argv[]) {
+    const std::string usage = std::string("Usage: ") + argv[0] +
+        " <input_filename>... | <archive.tcs> | @<listfile> | - [-c|--classify] [-o|--outputs 16bit,8bit,lin,csv,jpg,npy|all|none] [-j N] [--stats[=json]]\n"
+        "  -j N: batch frame workers, 0 = all hardware threads; more than the hardware threads (" + std::to_string(hardwareJobs()) + ") are clamped to them";
 
-    // Set the image info based on depth
-    int colorType = PNG_COLOR_TYPE_GRAY;
-    if (depth == 16) {
-        png_set_IHDR(png, info, image.cols, image.rows, 16, colorType,
-                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
-    } else {
-        png_set_IHDR(png, info, image.cols, image.rows, 8, colorType,
-                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    // Check if the user provided a filename argument
+    if (argc < 2) {
+        std::cerr << usage << std::endl;
+        return 1;
     }
 
-    png_write_info(png, info);
+    // Read configuration data
+    Config config = readConfig("config.txt");
 
-    // Handle endianness for 16-bit images
-    if (depth == 16) {
-        png_set_swap(png);  // Swap endianness if the image is stored in little-endian format
-    }
-    
-    // Write the image data
-    for (int y = 0; y < image.rows; ++y) {
-        if (depth == 16) {
-            // If the image is 16-bit, treat each pixel as a 16-bit value
-            png_bytep row = (png_bytep)(image.ptr<uint16_t>(y));
-            png_write_row(png, row);
+    // Output files: taken from config.txt, can be overridden on the command line
+    std::string outputList = config.frame_outputs;
+
+    // Input frames: paths (<archive>.tcs#<name> for a packed frame), whole archives,
+    // @listfile (one path per line) or - (paths on stdin)
+    std::vector<std::string> inputs;
+    bool batch = false;
+    bool showStats = false;
+    bool statsJson = false;
+    int jobs = 1;  // batch: frame workers (0 = all hardware threads)
+
+    // Parse command line arguments
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "-c" || args[i] == "--classify") {
+            outputList = "none";
+        } else if ((args[i] == "-o" || args[i] == "--outputs") && i + 1 < args.size()) {
+            outputList = args[++i];
+        } else if (args[i].rfind("-j", 0) == 0 && (args[i].size() > 2 || i + 1 < args.size())) {
+            std::string value = args[i].size() > 2 ? args[i].substr(2) : args[++i];
+            try {
+                jobs = std::stoi(value);
+            } catch (const std::exception &e) {
+                std::cerr << "Error: Invalid number of jobs: " << value << std::endl;
+                return 1;
+            }
+            jobs = clampJobs(jobs);
+        } else if (parseStatsFlag(args[i], statsJson)) {
+            showStats = true;
+            enableStats();
+        } else if (args[i] == "-") {
+            readFileList(std::cin, inputs);
+            batch = true;
+        } else if (args[i].size() > 1 && args[i][0] == '@') {
+            std::ifstream list(args[i].substr(1));
+            if (!list) {
+                std::cerr << "Error: Could not open file list: " << args[i].substr(1) << std::endl;
+                return 1;
+            }
+            readFileList(list, inputs);
+            batch = true;
+        } else if (isArchivePath(args[i])) {
+            if (!addArchiveFrames(args[i], inputs)) {
+                return 1;
+            }
+            batch = true;
         } else {
-            // If the image is 8-bit, treat each pixel as an 8-bit value
-            png_bytep row = (png_bytep)(image.ptr<uint8_t>(y));
-            png_write_row(png, row);
+            inputs.push_back(args[i]);
         }
     }
+    batch = batch || inputs.size() > 1;
 
-    png_write_end(png, nullptr);
-    png_destroy_write_struct(&png, &info);
-    fclose(fp);
-}
-
-void drawFrames(cv::Mat &img_lin, const Config &config) {
-    // Calculate the drill height based on the drill width
-    int drill_height = config.drill_width;
-    int margin = drill_height / 2;  // Calculate the margin above and below the drill
-
-    // Define the four corner points of the rectangle around the drill
-    cv::Point topLeft(config.drill_start_x, config.drill_start_y + margin);
-    cv::Point topRight(config.drill_end_x, config.drill_start_y + margin);
-    cv::Point bottomRight(config.drill_end_x, config.drill_start_y - margin);
-    cv::Point bottomLeft(config.drill_start_x, config.drill_start_y - margin);
-
-    // Draw the white frame around the drill using lines connecting the corner points
-    cv::line(img_lin, topLeft, topRight, cv::Scalar(255), 1); // Top edge
-    cv::line(img_lin, topRight, bottomRight, cv::Scalar(255), 1); // Right edge
-    cv::line(img_lin, bottomRight, bottomLeft, cv::Scalar(255), 1); // Bottom edge
-    cv::line(img_lin, bottomLeft, topLeft, cv::Scalar(255), 1); // Left edge
-
-    // Draw a white frame around the hotspot
-    cv::rectangle(img_lin,
-                  cv::Point(config.hotspot_x, config.hotspot_y),
-                  cv::Point(config.hotspot_x + config.hotspot_size, config.hotspot_y + config.hotspot_size),
-                  cv::Scalar(255), 1);
-}
-
-// Function to convert temperature matrix to images and save them
-void convertTemperatureToImage(const std::vector<std::vector<float>> &temperatureMatrix, const std::string &outputFilename, const Config &config) {
-    int rows = temperatureMatrix.size();
-    int cols = temperatureMatrix[0].size();
-
-    // Create OpenCV matrices to store the image data
-    cv::Mat img_16bit(rows, cols, CV_16UC1);  // 16-bit image for the 0-256 range
-    cv::Mat img_8bit(rows, cols, CV_8UC1);    // 8-bit image for the 0-128 range
-    cv::Mat img_lin(rows, cols, CV_8UC1);     // 8-bit image for the min-max range
-
-    // Find the minimum and maximum temperature in the matrix
-    float minTemp = std::numeric_limits<float>::max();
-    float maxTemp = std::numeric_limits<float>::min();
-    for (const auto& row : temperatureMatrix) {
-        float row_min = *std::min_element(row.begin(), row.end());
-        float row_max = *std::max_element(row.begin(), row.end());
-        minTemp = std::min(minTemp, row_min);
-        maxTemp = std::max(maxTemp, row_max);
-    }
-
-    // Convert temperature values to grayscale for all three images
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            float temp = temperatureMatrix[i][j];
-
-            // For the 16-bit image: scale temperature to 0-65535 (16-bit)
-            uint16_t pixelValue16 = static_cast<uint16_t>(std::clamp(temp/255.0f*65535.0f, 0.0f, 65535.0f));
-            img_16bit.at<uint16_t>(i, j) = pixelValue16;
-
-            // For the 8-bit image: scale temperature to 0-255 (8-bit, range 0-127)
-            uint8_t pixelValue8 = static_cast<uint8_t>(std::clamp(temp * 2.0f, 0.0f, 255.0f));
-            img_8bit.at<uint8_t>(i, j) = pixelValue8;
-
-            // For the linear scaled image: scale temperature to 0-255 based on min-max range
-            uint8_t pixelValueLin = static_cast<uint8_t>(std::clamp((temp - minTemp) / (maxTemp - minTemp) * 255.0f, 0.0f, 255.0f));
-            img_lin.at<uint8_t>(i, j) = pixelValueLin;
-        }
+    int outputs;
+    if ((inputs.empty() && !batch) || !parseFrameOutputs(outputList, outputs)) {
+        std::cerr << usage << std::endl;
+        return 1;
     }
 
-    // Save the 16-bit image with metadata
-    std::string outputFilename16bit = outputFilename + "_16bit.png";
-    saveImageWithMetadata(outputFilename16bit, img_16bit, "Temperature Range: 0-256", 16);
-
-    // Save the 8-bit image with metadata
-    std::string outputFilename8bit = outputFilename + "_8bit.png";
-    saveImageWithMetadata(outputFilename8bit, img_8bit, "Temperature Range: 0-128", 8);
-
-    // Save the linear scaled image with metadata
-    std::string outputFilenameLin = outputFilename + "_lin.png";
-    std::string minMaxText = "Min: " + std::to_string(minTemp) + " Max: " + std::to_string(maxTemp);
-    drawFrames(img_lin, config);
-    saveImageWithMetadata(outputFilenameLin, img_lin, minMaxText, 8);
-}
-
-// Function to save the temperature matrix to a tab-delimited text file
-void saveTemperatureMatrixToFile(const std::vector<std::vector<float>> &temperatureMatrix, const std::string &outputFilename) {
-    // Append ".txt" to the output filename
-    std::string fullFilename = outputFilename + ".csv";
-    
-    std::ofstream outFile(fullFilename);
+    // Single frame: the hot spot verdict, then the ROI line
+    if (!batch) {
+        // Run the pipeline: requested PNG images, CSV matrix, JPG and the hot spot verdict
+        std::vector<RoiResult> rois;
+        HotspotLocation hotspot;
+        int result = processFrame(inputs[0], config, outputs, &rois, nullptr, nullptr, &hotspot);
+        if (result >= 0) {
+            // Print the result of the comparison with the threshold
+            std::cout << result << std::endl;
 
-    // Check if the file opened successfully
-    if (!outFile.is_open()) {
-        std::cerr << "Error: Could not open file " << fullFilename << " for writing." << std::endl;
-        return;
-    }
-
-    // Iterate through the temperature matrix and write each value to the file
-    for (const auto &row : temperatureMatrix) {
-        for (size_t j = 0; j < row.size(); ++j) {
-            outFile << std::fixed << std::setprecision(2) << row[j]; // Write temperature with two decimal places
-            if (j < row.size() - 1) {
-                outFile << "\t"; // Add tab except for the last element in the row
+            // One line with the verdicts of all named ROIs (if any are configured)
+            if (!rois.empty()) {
+                std::cout << inputs[0] << "\t" << formatRoiResults(rois) << std::endl;
             }
-        }
-        outFile << "\n"; // New line at the end of each row
-    }
-
-    // Close the file
-    outFile.close();
-}
 
-// Function to convert raw image data to a YUYV422 image format and save it as JPG
-void convertImageDataToImage(const std::vector<uint16_t> &imageData, int rows, int cols, const std::string &outputFilename) {
-    // Create an OpenCV matrix to store the YUYV422 image data
-    cv::Mat img_yuyv(rows / 2, cols, CV_8UC2);  // YUYV422 format: 2 bytes per pixel (YUYV)
-
-    for (int i = 0; i < rows / 2; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            uint16_t value = imageData[i * cols + j];
-            uint8_t y = static_cast<uint8_t>(value >> 8);  // Extract the Y (luminance) component
-            uint8_t uv = static_cast<uint8_t>(value & 0xFF);  // Extract the U or V component (we'll treat as YUV422)
-
-            // Assuming YUYV format:
-            if (j % 2 == 0) {
-                img_yuyv.at<cv::Vec2b>(i, j) = cv::Vec2b(y, uv);  // Y component with U/V
-            } else {
-                img_yuyv.at<cv::Vec2b>(i, j) = cv::Vec2b(y, uv);  // Y component only
+            // One line with the located hot spot (hotspot_mode = auto)
+            if (config.hotspot_auto) {
+                std::cout << inputs[0] << "\t" << formatHotspotLocation(hotspot) << std::endl;
             }
         }
-    }
-
-    // Convert the YUYV422 image to BGR (color) format for saving as JPG
-    cv::Mat img_bgr;
-    cv::cvtColor(img_yuyv, img_bgr, cv::COLOR_YUV2BGR_YUYV);
-
-    // Save the image as JPG
-    cv::imwrite(outputFilename + ".jpg", img_bgr);
-}
 
-/* HOT SPOT */
-
-float calculateHotspotAverage(const std::vector<std::vector<float>> &temperatureMatrix, const Config &config) {
-    std::vector<std::vector<float>>::size_type startX = config.hotspot_x;
-    std::vector<std::vector<float>>::size_type startY = config.hotspot_y;
-    std::vector<std::vector<float>>::size_type size = config.hotspot_size;
-
-    float sum = 0.0;
-    int count = 0;
-
-    // Sum the temperatures in the square region
-    for (std::vector<std::vector<float>>::size_type i = startY; i < startY + size && i < temperatureMatrix.size(); ++i) {
-        for (std::vector<std::vector<float>>::size_type j = startX; j < startX + size && j < temperatureMatrix[i].size(); ++j) {
-            sum += temperatureMatrix[i][j];
-            ++count;
+        if (showStats) {
+            printStats(std::cerr, statsJson);
         }
+        return result < 0 ? 1 : 0;
     }
 
-    if (count == 0) return 0.0f;  // Avoid division by zero
-
-    return sum / count;  // Return the average temperature
-}
-
-void compareTemperatureWithThreshold(float averageTemp, const Config &config) {
-    if (averageTemp >= config.hotspot_temp_threshold) {
-        std::cout << "1" << std::endl;  // Hot spot is above the threshold
-    } else {
-        std::cout << "0" << std::endl;  // Hot spot is below the threshold
-    }
-}
-// Function to remove the file extension from a filename
-std::string removeFileExtension(const std::string &filename) {
-    size_t lastDot = filename.find_last_of(".");
-    if (lastDot == std::string::npos) return filename;
-    return filename.substr(0, lastDot);
-}
-
-int main(int argc, char *argv[]) {
-    // Check if the user provided a filename argument
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_filename>" << std::endl;
-        return 1;
-    }
-
-    // Get the input filename and remove its extension
-    std::string inputFilename = argv[1];
-    std::string baseFilename = removeFileExtension(inputFilename);
+    // Batch: every frame in this process, reading overlapped with processing (FramePipeline.h),
+    // one tab separated line per frame in input order
+    int failed = 0;
+    runFramePipeline(inputs, config, outputs, jobs, PIPELINE_DEPTH, [&](const std::string &inputFilename, const FrameOutcome &outcome) {
+        printBatchResult(inputFilename, outcome.result, outcome.hotspotMean, outcome.rois, config.hotspot_auto ? &outcome.hotspot : nullptr);
+        failed += outcome.result < 0;
+    });
+    std::cout.flush();
 
-    // Read configuration data
-    Config config = readConfig("config.txt");
-
-    // Variables to store image and temperature data
-    std::vector<uint16_t> imageData, temperatureData;
-    int rows, cols;
-
-    // Load data from the binary file
-    if (!loadDataFromFile(inputFilename, imageData, temperatureData, rows, cols)) {
-        return 1;
+    if (showStats) {
+        printStats(std::cerr, statsJson);
     }
-
-    // Convert the temperature data to a temperature matrix in Celsius
-    std::vector<std::vector<float>> temperatureMatrix = convertToTemperature(temperatureData, rows, cols);
-
-    // Convert the temperature matrix to an image and save as PNG
-    convertTemperatureToImage(temperatureMatrix, baseFilename, config);
-
-    // Save the temperature matrix to a file named "temperature_data.csv"
-    saveTemperatureMatrixToFile(temperatureMatrix, baseFilename);
-
-    // Convert the raw image data to a YUYV422 image and save as JPG
-    convertImageDataToImage(imageData, rows, cols, baseFilename);
-
-    // Calculate the average temperature in the hot spot
-    float averageTemp = calculateHotspotAverage(temperatureMatrix, config);
-
-    // Compare the average temperature with the threshold and print result
-    compareTemperatureWithThreshold(averageTemp, config);
-
-    return 0;
+    return failed > 0 ? 1 : 0;
 }
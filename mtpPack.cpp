@@ -0,0 +1,191 @@
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "TcsArchive.h"
+#include "FrameIndex.h"
+
+// mtpPack: packs the .tc0 frames of a session directory into one .tcs archive and back
+
+void printUsage(const char *program) {
+    std::cerr << "Usage: " << program << " pack <directory> <archive.tcs> [-z|--compress] [-l N]" << std::endl;
+    std::cerr << "       " << program << " unpack <archive.tcs> <directory>" << std::endl;
+    std::cerr << "       " << program << " list <archive.tcs>" << std::endl;
+}
+
+// Function to read a whole file into a buffer
+bool readFile(const std::string &filename, std::vector<uint8_t> &data) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Error: Could not open file: " << filename << std::endl;
+        return false;
+    }
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+// Function to pack the .tc0 files of a directory, in the order mtpSeries processes them
+int packDirectory(const std::string &directory, const std::string &archivePath, bool compress, int level) {
+    if (!std::filesystem::is_directory(directory)) {
+        std::cerr << "Error: Not a directory: " << directory << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> tc0Files;
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".tc0") {
+            tc0Files.push_back(entry.path().string());
+        }
+    }
+    std::sort(tc0Files.begin(), tc0Files.end());
+
+    TcsWriter writer;
+    if (!writer.create(archivePath, compress, level)) {
+        return 1;
+    }
+
+    std::vector<uint8_t> data;
+    uint64_t rawBytes = 0;
+    for (const auto &file : tc0Files) {
+        uint64_t size;
+        int64_t mtime;
+        if (!fileKey(file, size, mtime) || !readFile(file, data)) {
+            return 1;
+        }
+        if (!writer.add(std::filesystem::path(file).filename().string(), mtime, data.data(), data.size())) {
+            return 1;
+        }
+        rawBytes += data.size();
+    }
+
+    if (!writer.finish()) {
+        return 1;
+    }
+
+    uint64_t storedBytes = 0;
+    for (const auto &frame : writer.frames()) {
+        storedBytes += frame.storedSize;
+    }
+    std::cout << "Packed " << tc0Files.size() << " frames: " << rawBytes << " -> " << storedBytes << " bytes" << std::endl;
+    return 0;
+}
+
+// Function to write every frame of an archive back as a .tc0 file with its original timestamp
+int unpackArchive(const std::string &archivePath, const std::string &directory) {
+    TcsArchive archive;
+    if (!archive.open(archivePath)) {
+        return 1;
+    }
+
+    std::filesystem::create_directories(directory);
+
+    std::vector<uint16_t> words;
+    for (size_t i = 0; i < archive.size(); ++i) {
+        const TcsArchive::Frame &frame = archive.frame(i);
+        if (!archive.read(i, words)) {
+            return 1;
+        }
+
+        // Never write outside the target directory, whatever the archive says
+        if (!isSafeFrameName(frame.name)) {
+            std::cerr << "Error: Invalid frame name in archive: " << frame.name << std::endl;
+            return 1;
+        }
+        std::string filename = (std::filesystem::path(directory) / frame.name).string();
+        FILE *fp = fopen(filename.c_str(), "wb");
+        if (!fp) {
+            std::cerr << "Error: Could not open file for writing: " << filename << std::endl;
+            return 1;
+        }
+        bool ok = fwrite(words.data(), 1, frame.rawSize, fp) == frame.rawSize;
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok) {
+            std::cerr << "Error: Could not write file: " << filename << std::endl;
+            return 1;
+        }
+
+        // Restore the modification time recorded when packing
+        struct timespec times[2];
+        times[0].tv_sec = times[1].tv_sec = frame.timestamp / 1000000000LL;
+        times[0].tv_nsec = times[1].tv_nsec = frame.timestamp % 1000000000LL;
+        utimensat(AT_FDCWD, filename.c_str(), times, 0);
+    }
+
+    std::cout << "Unpacked " << archive.size() << " frames to " << directory << std::endl;
+    return 0;
+}
+
+// Function to print the index of an archive: number, name, timestamp, sizes and codec
+int listArchive(const std::string &archivePath) {
+    TcsArchive archive;
+    if (!archive.open(archivePath)) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < archive.size(); ++i) {
+        const TcsArchive::Frame &frame = archive.frame(i);
+        std::cout << i << "\t" << frame.name << "\t" << frame.timestamp << "\t" << frame.rawSize << "\t" << frame.storedSize << "\t"
+                  << (frame.codec == TcsArchive::CODEC_STORED ? "stored" : "delta+deflate") << std::endl;
+    }
+    return 0;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::string command = argv[1];
+    std::vector<std::string> args(argv + 2, argv + argc);
+
+    if (command == "pack") {
+        bool compress = false;
+        int level = 6;
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "-z" || args[i] == "--compress") {
+                compress = true;
+            } else if (args[i] == "-l" && i + 1 < args.size()) {
+                try {
+                    level = std::stoi(args[++i]);
+                } catch (const std::exception &e) {
+                    std::cerr << "Error: Invalid compression level: " << args[i] << std::endl;
+                    return 1;
+                }
+                if (level < 0 || level > 9) {
+                    std::cerr << "Error: Invalid compression level: " << args[i] << std::endl;
+                    return 1;
+                }
+                compress = true;
+            } else {
+                paths.push_back(args[i]);
+            }
+        }
+        if (paths.size() != 2) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return packDirectory(paths[0], paths[1], compress, level);
+    }
+
+    if (command == "unpack" && args.size() == 2) {
+        return unpackArchive(args[0], args[1]);
+    }
+
+    if (command == "list" && args.size() == 1) {
+        return listArchive(args[0]);
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}
@@ -9,14 +9,30 @@
 #include <limits>
 #include <opencv2/opencv.hpp>
 #include <algorithm> // For std::sort
+#include <cctype>
 #include <stdexcept>
+#include <set>
+#include <csignal>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
 
-#define silentMTPF 1  // Set to 1 to suppress mtpf error messages
-#define ZERO_COUNT 4    //how many frames has to be without hotspot 
-                        // to be considered as a gap (oneShot mode) 
-                        // between beforeShot and afterShot
+#define silentMTPF 1  // Set to 1 to suppress frame classification error messages
+#define SCAN_WINDOW 16  // frames per worker classified between two merges (-j mode)
+#define VIDEO_FPS 25    // default frame rate of the exported video
+#define VIDEO_READAHEAD 4  // frames hinted to the kernel ahead of the one being rendered
                         
 #include "ConfigReader.h"
+#include "FrameProcessor.h"
+#include "FramePool.h"
+#include "FrameIndex.h"
+#include "ShotDetector.h"
+#include "ParallelFor.h"
+#include "TcsArchive.h"
+#include "Stats.h"
+#include "SessionStats.h"
+#include "SessionShards.h"
+#include "FalseColor.h"
 
 // // Define the Config struct
 // struct Config {
@@ -31,61 +47,113 @@
 //     float hotspot_temp_threshold;
 // };
 
-// Function to check if a command exists in the system
-bool commandExists(const std::string &command) {
-    std::string cmd = "which " + command + " > /dev/null 2>&1";
-    return system(cmd.c_str()) == 0;
+// Result of looking up or classifying one frame
+struct FrameResult {
+    FrameStats stats;
+    std::vector<RoiStats> rois;  // ROI statistics (default mode with roi_* entries in config.txt)
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    bool cached = false;
+};
+
+// Function to return the name of a frame inside its directory (the index key)
+std::string frameName(const std::string &filename) {
+    return std::filesystem::path(filename).filename().string();
 }
 
-// Function to execute mtpf and return the result (0 or 1)
-int runMtpf(const std::string &filename) {
-    // Check if mtpf command exists in the system
-    if (!commandExists("mtpFrame")) {
-        // Check if local file './mtpf' exists
-        if (!std::filesystem::exists("./mtpFrame")) {
-            if (!silentMTPF) {
-                std::cerr << "Error: mtpFrame command or local './mtpFrame' file not found." << std::endl;
-            }
-            std::exit(EXIT_FAILURE); // Exit the program if neither is found
-        }
+// Function to return the buffer pools of the worker threads; they live for the whole run,
+// so the frames of every scan window reuse the buffers of the first one
+std::vector<FramePool> &workerPools(int jobs) {
+    static std::vector<FramePool> pools;
+    if (pools.size() < static_cast<size_t>(std::max(jobs, 1))) {
+        pools = std::vector<FramePool>(std::max(jobs, 1));
     }
+    return pools;
+}
 
-    // Execute mtpf command or local file './mtpf' with the provided filename
-    std::string command = "mtpFrame " + filename;
-    if (std::filesystem::exists("./mtpFrame")) {
-        command = "./mtpFrame " + filename;
+// Function to measure the named ROIs of a frame (needs the whole converted frame)
+std::vector<RoiStats> runRois(const std::string &filename, const Config &config, FramePool &pool) {
+    Tc0File &file = pool.file;
+    if (!file.open(filename)) {
+        return std::vector<RoiStats>();
     }
+    pool.prepare(file.rows(), file.cols());
+    convertToTemperature(file.temperatureData(), file.rows(), file.cols(), pool.temperature);
+    file.close();
+    std::vector<RoiStats> result = measureRois(pool.temperature, config, pool.table);
+    pool.recycle();
+    return result;
+}
+
+// Function to get the statistics of a single frame: from the index when the file is unchanged,
+// otherwise decoded in-process. With `withRois`, a hit also needs the cached ROI statistics
+// (returned in result.rois); on a miss they are left to the caller.
+FrameResult runMtpf(const std::string &filename, const Config &config, const FrameIndex *index, HotspotTracker *tracker = nullptr,
+                    bool withRois = false) {
+    FrameResult result;
+    bool haveKey = fileKey(filename, result.size, result.mtime);
 
-    FILE *pipe = popen(command.c_str(), "r");
-    if (!pipe) {
-        if (!silentMTPF) {
-            std::cerr << "Error: Could not execute mtpFrame for file: " << filename << std::endl;
+    if (index && haveKey) {
+        const std::vector<RoiStats> *rois = nullptr;
+        if (const FrameStats *stats = index->find(frameName(filename), result.size, result.mtime, withRois ? &rois : nullptr)) {
+            result.stats = *stats;
+            if (rois) {
+                result.rois = *rois;
+            }
+            result.cached = true;
+            countStats(COUNTER_INDEX_HITS);
+            return result;
         }
-        return -1;
     }
 
-    char buffer[128];
-    std::string result;
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        result += buffer;
-    }
-    pclose(pipe);
+    result.stats = calculateFrameStats(filename, config, tracker);
 
-    int returnValue;
-    try {
-        returnValue = std::stoi(result);
-    } catch (const std::exception &e) {
-        if (!silentMTPF) {
-            std::cerr << "Error: Could not parse mtpFrame output for file: " << filename << std::endl;
-        }
-        returnValue = -1;
+    if (!result.stats.valid && !silentMTPF) {
+        std::cerr << "Error: Could not classify frame: " << filename << std::endl;
     }
 
     if (!silentMTPF) {
-        std::cout << filename << ": " << returnValue << std::endl;
+        std::cout << filename << ": " << classifyFrameStats(result.stats, config) << std::endl;
+    }
+
+    return result;
+}
+
+// Function to get the statistics of files [begin, end) on `jobs` worker threads, in file order.
+// Newly decoded frames are added to the index afterwards (on the calling thread).
+// With `rois` set, the ROI statistics of every frame are returned as well; they are cached in
+// the index with the statistics, so unchanged frames are not decoded for them either.
+std::vector<FrameStats> runMtpfRange(const std::vector<std::string> &files, size_t begin, size_t end, const Config &config, int jobs, FrameIndex *index,
+                                     std::vector<std::vector<RoiStats>> *rois = nullptr) {
+    std::vector<FrameResult> results(end - begin);
+    std::vector<FramePool> &pools = workerPools(jobs);
+    // A located hot spot depends on its frame only, so any worker's tracker (scratch buffers) will do
+    parallelFor(end - begin, jobs, [&](size_t i, int worker) {
+        results[i] = runMtpf(files[begin + i], config, index, &pools[worker].tracker, rois != nullptr);
+        if (rois && !results[i].cached) {
+            results[i].rois = runRois(files[begin + i], config, pools[worker]);
+        }
+    });
+
+    std::vector<FrameStats> stats(results.size());
+    if (rois) {
+        rois->resize(results.size());
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+        stats[i] = results[i].stats;
+        if (index && !results[i].cached && results[i].stats.valid) {
+            index->put(frameName(files[begin + i]), results[i].size, results[i].mtime, results[i].stats, rois ? &results[i].rois : nullptr);
+        }
+        if (rois) {
+            (*rois)[i] = std::move(results[i].rois);
+        }
     }
+    return stats;
+}
 
-    return returnValue;
+// Function to return how many frames are classified at once before the results are merged
+size_t scanWindow(int jobs) {
+    return jobs > 1 ? static_cast<size_t>(jobs) * SCAN_WINDOW : 1;
 }
 
 // // Function to read configuration file and return config values
@@ -123,48 +191,523 @@ int runMtpf(const std::string &filename) {
 //     return config;
 // }
 
-// Function to find the first and second shots based on mtpf results
-bool findShots(const std::vector<std::string> &tc0Files, std::string &beforeShot, std::string &afterShot) {
-    bool foundFirst = false;
-    int zeroCount = 0;
-    for (const auto &file : tc0Files) {
-        if (runMtpf(file) == 1) {
-            if (!foundFirst) {
-                beforeShot = file;
-                foundFirst = true;
-                zeroCount = 0;
-            } else if (zeroCount >= ZERO_COUNT) {
-                afterShot = file;
+// Function to find the first and second shots based on frame classification results.
+// Frames that cannot be read (e.g. still being written) are added to `unreadable` if given.
+bool findShots(const std::vector<std::string> &tc0Files, const Config &config, int jobs, FrameIndex *index, ShotDetector &detector,
+               std::set<std::string> *unreadable = nullptr) {
+    // Frames are classified window by window, so the scan still stops at the second shot
+    size_t window = scanWindow(jobs);
+    for (size_t begin = 0; begin < tc0Files.size(); begin += window) {
+        size_t end = std::min(begin + window, tc0Files.size());
+        std::vector<FrameStats> stats = runMtpfRange(tc0Files, begin, end, config, jobs, index);
+        for (size_t i = begin; i < end; ++i) {
+            if (unreadable && !stats[i - begin].valid) {
+                unreadable->insert(tc0Files[i]);
+            }
+            if (detector.feed(tc0Files[i], classifyFrameStats(stats[i - begin], config), stats[i - begin])) {
                 return true;
             }
-        } else {
-            if (foundFirst) {
-                ++zeroCount;
+        }
+    }
+    return false;
+}
+
+// Function to find the shots coarse to fine: every `stride`-th frame (and the last one) is
+// classified first, the frames between two samples only when the samples differ (hot/cold).
+// Between two samples of the same class the frames are taken to be of that class as well, so
+// the shots are the same as with findShots() whenever every run of hot or cold frames is at
+// least `stride` frames long (no run fits between two samples). Frames that were read and
+// found unreadable are added to `unreadable` if given.
+bool findShotsStrided(const std::vector<std::string> &tc0Files, const Config &config, int jobs, FrameIndex *index, size_t stride,
+                      ShotDetector &detector, std::set<std::string> *unreadable = nullptr) {
+    if (tc0Files.empty()) {
+        return false;
+    }
+
+    std::vector<size_t> samples;
+    for (size_t i = 0; i < tc0Files.size(); i += stride) {
+        samples.push_back(i);
+    }
+    if (samples.back() != tc0Files.size() - 1) {
+        samples.push_back(tc0Files.size() - 1);
+    }
+
+    bool havePrevious = false;
+    bool previousHot = false;
+    size_t previous = 0;
+    size_t window = scanWindow(jobs);
+    for (size_t begin = 0; begin < samples.size(); begin += window) {
+        size_t end = std::min(begin + window, samples.size());
+        std::vector<std::string> sampleFiles;
+        for (size_t j = begin; j < end; ++j) {
+            sampleFiles.push_back(tc0Files[samples[j]]);
+        }
+        std::vector<FrameStats> sampleStats = runMtpfRange(sampleFiles, 0, sampleFiles.size(), config, jobs, index);
+
+        for (size_t j = begin; j < end; ++j) {
+            size_t current = samples[j];
+            const FrameStats &stats = sampleStats[j - begin];
+            int verdict = classifyFrameStats(stats, config);
+            bool hot = verdict == 1;
+
+            if (havePrevious && current > previous + 1) {
+                if (hot == previousHot) {
+                    // Same class on both sides: the frames in between are of that class too (the
+                    // detector only keeps the statistics of the first frame of a hot run, a sample)
+                    for (size_t i = previous + 1; i < current; ++i) {
+                        if (detector.feed(tc0Files[i], hot ? 1 : 0, FrameStats())) {
+                            return true;
+                        }
+                    }
+                } else {
+                    // Transition between the samples: classify every frame in between
+                    std::vector<FrameStats> dense = runMtpfRange(tc0Files, previous + 1, current, config, jobs, index);
+                    for (size_t i = previous + 1; i < current; ++i) {
+                        const FrameStats &frameStats = dense[i - previous - 1];
+                        if (unreadable && !frameStats.valid) {
+                            unreadable->insert(tc0Files[i]);
+                        }
+                        if (detector.feed(tc0Files[i], classifyFrameStats(frameStats, config), frameStats)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+
+            if (unreadable && !stats.valid) {
+                unreadable->insert(tc0Files[current]);
             }
+            if (detector.feed(tc0Files[current], verdict, stats)) {
+                return true;
+            }
+            havePrevious = true;
+            previous = current;
+            previousHot = hot;
         }
     }
     return false;
 }
 
-// Function to calculate the maximum temperature along the drill line
-float calculateMaxTemperatureOnDrillLine(const std::string &imageFilename, const Config &config) {
-    cv::Mat img = cv::imread(imageFilename, cv::IMREAD_UNCHANGED); // Read 16-bit image
-    if (img.empty()) {
-        std::cerr << "Error: Could not read image file: " << imageFilename << std::endl;
-        return std::numeric_limits<float>::lowest();
+// Function to print the shots found in one-shot mode and write their output files
+void reportShots(const ShotDetector &detector, const Config &config) {
+    std::cout << "Before shot: " << detector.beforeShot() << std::endl;
+    std::cout << "After shot: " << detector.afterShot() << std::endl;
+
+    // Drill band maximum of the two frames (computed from the raw temperature data)
+    float maxTempBefore = detector.beforeStats().drillMax;
+    float maxTempAfter = detector.afterStats().drillMax;
+
+    std::cout << "Max temperature before shot: " << maxTempBefore << std::endl;
+    std::cout << "Max temperature after shot: " << maxTempAfter << std::endl;
+
+    // Output files of the two shot frames (as selected by frame_outputs)
+    int outputs = OUTPUT_ALL;
+    parseFrameOutputs(config.frame_outputs, outputs);
+    processFrame(detector.beforeShot(), config, outputs);
+    processFrame(detector.afterShot(), config, outputs);
+}
+
+// Function to classify files [begin, end) and print one line per frame (default mode).
+// Frames that cannot be read (e.g. still being written) are added to `unreadable` if given.
+void printResults(const std::vector<std::string> &tc0Files, size_t begin, size_t end, const Config &config, int jobs, FrameIndex *index,
+                  std::set<std::string> *unreadable = nullptr) {
+    std::vector<std::vector<RoiStats>> rois;
+    std::vector<FrameStats> stats = runMtpfRange(tc0Files, begin, end, config, jobs, index,
+                                                 config.rois.empty() ? nullptr : &rois);
+    for (size_t i = begin; i < end; ++i) {
+        if (unreadable && !stats[i - begin].valid) {
+            unreadable->insert(tc0Files[i]);
+        }
+        std::cout << tc0Files[i] << ": " << classifyFrameStats(stats[i - begin], config);
+        // Named ROI verdicts on the same line (only with roi_* entries in config.txt)
+        if (!rois.empty()) {
+            std::cout << "\t" << formatRoiResults(judgeRois(rois[i - begin], config));
+        }
+        std::cout << std::endl;
+    }
+}
+
+/* ANALYTICS MODE */
+
+// Function to return the prefix of the files written for a session (analytics, shard manifest and
+// results): <directory>/session_* or <archive without .tcs>_*
+std::string sessionPrefix(const std::string &session, bool archiveMode) {
+    if (archiveMode) {
+        return (std::filesystem::path(session).parent_path() / std::filesystem::path(session).stem()).string();
+    }
+    return (std::filesystem::path(session) / "session").string();
+}
+
+// Function to compute the session analytics in one streaming pass over every frame:
+//   <prefix>_series.csv                        hot spot mean, drill line max, min and max per frame
+//   <prefix>_max/_mean/_variance.csv and .png  per-pixel maps and their heatmaps
+// Each window of frames is split into `jobs` consecutive slices, every slice is added to its own
+// accumulator and the accumulators are merged in slice order, so the result does not depend on
+// thread timing. Memory is a few frames per worker, whatever the length of the session.
+bool analyzeSession(const std::vector<std::string> &tc0Files, const Config &config, int jobs, FrameIndex *index, const std::string &prefix) {
+    std::string seriesPath = prefix + "_series.csv";
+    FILE *series = std::fopen(seriesPath.c_str(), "wb");
+    if (!series) {
+        std::cerr << "Error: Could not open file for writing: " << seriesPath << std::endl;
+        return false;
+    }
+    std::fprintf(series, "frame\tfile\thotspot_mean\tdrill_max\tmin\tmax\n");
+
+    const int slices = std::max(jobs, 1);
+    std::vector<FramePool> &pools = workerPools(jobs);
+    std::vector<PixelStatistics> partial(slices);
+    PixelStatistics total;
+    size_t skipped = 0;
+
+    const size_t window = static_cast<size_t>(slices) * SCAN_WINDOW;
+    for (size_t begin = 0; begin < tc0Files.size(); begin += window) {
+        size_t end = std::min(begin + window, tc0Files.size());
+        size_t sliceSize = (end - begin + slices - 1) / slices;
+        std::vector<FrameResult> results(end - begin);
+        std::vector<size_t> sliceSkipped(slices, 0);
+
+        parallelFor(slices, jobs, [&](size_t s, int worker) {
+            FramePool &pool = pools[worker];
+            partial[s].clear();
+            size_t first = begin + s * sliceSize;
+            size_t last = std::min(first + sliceSize, end);
+            for (size_t i = first; i < last; ++i) {
+                FrameResult &result = results[i - begin];
+                fileKey(tc0Files[i], result.size, result.mtime);
+                if (!pool.file.open(tc0Files[i])) {
+                    ++sliceSkipped[s];
+                    continue;
+                }
+                result.stats = calculateFrameStats(pool.file.temperatureData(), pool.file.rows(), pool.file.cols(), config, &pool.tracker);
+                pool.prepare(pool.file.rows(), pool.file.cols());
+                convertToTemperature(pool.file.temperatureData(), pool.file.rows(), pool.file.cols(), pool.temperature);
+                pool.file.close();
+                if (!partial[s].add(pool.temperature)) {
+                    ++sliceSkipped[s];
+                }
+                pool.recycle();
+            }
+        }, 1);
+
+        for (int s = 0; s < slices; ++s) {
+            if (!total.merge(partial[s])) {
+                skipped += partial[s].count();
+            }
+            skipped += sliceSkipped[s];
+        }
+
+        for (size_t i = begin; i < end; ++i) {
+            const FrameResult &result = results[i - begin];
+            if (result.stats.valid) {
+                std::fprintf(series, "%zu\t%s\t%.2f\t%.2f\t%.2f\t%.2f\n", i, frameName(tc0Files[i]).c_str(), result.stats.hotspotMean,
+                             result.stats.drillMax, result.stats.minTemp, result.stats.maxTemp);
+                if (index) {
+                    index->put(frameName(tc0Files[i]), result.size, result.mtime, result.stats);
+                }
+            } else {
+                std::fprintf(series, "%zu\t%s\tnan\tnan\tnan\tnan\n", i, frameName(tc0Files[i]).c_str());
+            }
+        }
+    }
+
+    if (std::fclose(series) != 0) {
+        std::cerr << "Error: Could not write file: " << seriesPath << std::endl;
+        return false;
+    }
+    std::cout << "Series: " << seriesPath << std::endl;
+
+    if (skipped > 0) {
+        std::cerr << "Warning: " << skipped << " frame(s) left out of the pixel maps (unreadable or of another size)." << std::endl;
+    }
+    if (total.count() == 0) {
+        std::cerr << "Error: No frames to analyze." << std::endl;
+        return false;
+    }
+
+    ThermalFrame map;
+    total.maxMap(map);
+    saveStatisticsMap(map, prefix + "_max");
+    total.meanMap(map);
+    saveStatisticsMap(map, prefix + "_mean");
+    total.varianceMap(map);
+    saveStatisticsMap(map, prefix + "_variance");
+    std::cout << "Pixel maps (" << total.count() << " frames): " << prefix << "_{max,mean,variance}.{csv,png}" << std::endl;
+    return true;
+}
+
+/* SHARDED MODE */
+
+// Function to return the paths of the frames of a manifest, as the directory listing or the archive gives them
+std::vector<std::string> manifestFiles(const ShardManifest &manifest, const std::string &session, bool archiveMode) {
+    std::vector<std::string> files;
+    files.reserve(manifest.names.size());
+    for (const auto &name : manifest.names) {
+        files.push_back(archiveMode ? archiveMemberPath(session, name) : (std::filesystem::path(session) / name).string());
+    }
+    return files;
+}
+
+// Function to compute the statistics (and ROI statistics) of the frames of one shard and write its
+// result file; the shard is classified window by window like the default mode
+bool runShard(const std::vector<std::string> &files, const ShardManifest &manifest, size_t shard, const std::string &manifestPath,
+              const Config &config, int jobs, FrameIndex *index) {
+    ShardResults results;
+    results.shard = shard;
+    results.first = manifest.bounds[shard];
+    results.manifestKey = manifest.key;
+    results.configKey = shardConfigKey(config);
+
+    size_t end = manifest.bounds[shard + 1];
+    size_t window = scanWindow(jobs);
+    for (size_t begin = results.first; begin < end; begin += window) {
+        size_t last = std::min(begin + window, end);
+        std::vector<std::vector<RoiStats>> rois;
+        std::vector<FrameStats> stats = runMtpfRange(files, begin, last, config, jobs, index, config.rois.empty() ? nullptr : &rois);
+        results.stats.insert(results.stats.end(), stats.begin(), stats.end());
+        rois.resize(stats.size());
+        results.rois.insert(results.rois.end(), rois.begin(), rois.end());
+    }
+
+    std::string path = shardResultPath(manifestPath, shard);
+    if (!saveShardResults(results, path)) {
+        return false;
+    }
+    std::cout << "Shard " << shard << "/" << manifest.shards() << ": frames " << results.first << ".." << end << " -> " << path << std::endl;
+    return true;
+}
+
+// Function to merge the shard results in manifest order, with the output of a single run over the
+// whole session: one line per frame, or (one-shot mode) the shots found by one state machine fed
+// across the shard boundaries. The one-shot merge stops at the second shot, so the shards after
+// it need not have finished.
+bool mergeShards(const std::vector<std::string> &files, const ShardManifest &manifest, const std::string &manifestPath, const Config &config,
+                 bool oneShotMode) {
+    uint64_t configKey = shardConfigKey(config);
+    ShotDetector detector;
+    for (size_t shard = 0; shard < manifest.shards(); ++shard) {
+        ShardResults results;
+        std::string path = shardResultPath(manifestPath, shard);
+        if (!loadShardResults(path, manifest, shard, configKey, results)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < results.stats.size(); ++i) {
+            const std::string &file = files[results.first + i];
+            int verdict = classifyFrameStats(results.stats[i], config);
+            if (oneShotMode) {
+                if (detector.feed(file, verdict, results.stats[i])) {
+                    reportShots(detector, config);
+                    return true;
+                }
+                continue;
+            }
+            std::cout << file << ": " << verdict;
+            if (!config.rois.empty()) {
+                std::cout << "\t" << formatRoiResults(judgeRois(results.rois[i], config));
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    if (oneShotMode) {
+        std::cout << "No suitable shots found." << std::endl;
+    }
+    return true;
+}
+
+/* VIDEO MODE */
+
+// Settings of the exported video (--video and its options)
+struct VideoOptions {
+    std::string path;
+    size_t every = 1;        // decimation: every K-th frame of the session
+    double fps = VIDEO_FPS;  // playback rate
+    bool fixedRange = false;  // --video-range MIN:MAX, otherwise the session-global range
+    float minTemp = 0.0f;
+    float maxTemp = 0.0f;
+};
+
+// Function to choose the codec from the file name: MPEG-4 for .mp4/.mov/.m4v, Motion JPEG otherwise (.avi)
+int videoFourcc(const std::string &path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (extension == ".mp4" || extension == ".mov" || extension == ".m4v") {
+        return cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+    }
+    return cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+}
+
+// Function to find the temperature range of a set of frames from their statistics (which come
+// from the index for unchanged frames, so a re-export does not read the frames twice)
+bool sessionRange(const std::vector<std::string> &files, const Config &config, int jobs, FrameIndex *index, float &minTemp, float &maxTemp) {
+    bool found = false;
+    size_t window = scanWindow(jobs);
+    for (size_t begin = 0; begin < files.size(); begin += window) {
+        size_t end = std::min(begin + window, files.size());
+        for (const FrameStats &stats : runMtpfRange(files, begin, end, config, jobs, index)) {
+            if (!stats.valid) continue;
+            minTemp = found ? std::min(minTemp, stats.minTemp) : stats.minTemp;
+            maxTemp = found ? std::max(maxTemp, stats.maxTemp) : stats.maxTemp;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// Function to render the session into one video file: every `every`-th frame, false-coloured
+// through a raw word to colour table of one fixed or session-global range (no per-frame
+// rescaling, so the colours do not flicker) with the drill, hot spot and ROI frames of
+// drawFrames. Frames are streamed one at a time through reused buffers, so memory does not
+// grow with the session; the next frames are read ahead while one is encoded.
+bool exportVideo(const std::vector<std::string> &tc0Files, const Config &config, int jobs, FrameIndex *index, const VideoOptions &options) {
+    std::vector<std::string> files;
+    for (size_t i = 0; i < tc0Files.size(); i += options.every) {
+        files.push_back(tc0Files[i]);
+    }
+
+    float minTemp = options.minTemp;
+    float maxTemp = options.maxTemp;
+    if (!options.fixedRange && !sessionRange(files, config, jobs, index, minTemp, maxTemp)) {
+        std::cerr << "Error: No frames to render." << std::endl;
+        return false;
+    }
+    FalseColorLut lut;
+    lut.build(minTemp, maxTemp);
+
+    StageTimer timer(STAGE_VIDEO);
+    cv::VideoWriter writer;
+    cv::Size videoSize;
+    FramePool pool;
+    HotspotTracker tracker;
+    cv::Mat bgr;
+    size_t written = 0, skipped = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (i == 0) {
+            for (size_t j = 0; j < std::min<size_t>(VIDEO_READAHEAD, files.size()); ++j) {
+                adviseFrameFile(files[j]);
+            }
+        } else if (i + VIDEO_READAHEAD - 1 < files.size()) {
+            adviseFrameFile(files[i + VIDEO_READAHEAD - 1]);
+        }
+
+        Tc0File &file = pool.file;
+        if (!file.open(files[i]) || !lut.apply(file.temperatureData(), file.rows(), file.cols(), bgr)) {
+            file.close();
+            ++skipped;
+            continue;
+        }
+
+        // The first frame sets the size of the video; frames of another size are left out
+        if (!writer.isOpened()) {
+            videoSize = bgr.size();
+            if (!writer.open(options.path, videoFourcc(options.path), options.fps, videoSize, true)) {
+                std::cerr << "Error: Could not open video for writing: " << options.path << std::endl;
+                return false;
+            }
+        } else if (bgr.cols != videoSize.width || bgr.rows != videoSize.height) {
+            file.close();
+            ++skipped;
+            continue;
+        }
+        HotspotLocation location;
+        if (config.hotspot_auto) {
+            location = tracker.locate(file.temperatureData(), file.rows(), file.cols(), config);
+        }
+        file.close();
+        drawFrames(bgr, config, config.hotspot_auto ? &location : nullptr);
+        writer.write(bgr);
+        ++written;
+    }
+    writer.release();
+
+    if (skipped > 0) {
+        std::cerr << "Warning: " << skipped << " frame(s) left out of the video (unreadable or of another size)." << std::endl;
+    }
+    if (written == 0) {
+        std::cerr << "Error: No frames to render." << std::endl;
+        return false;
+    }
+    std::cout << "Video: " << options.path << " (" << written << " frames at " << options.fps << " fps, "
+              << minTemp << " to " << maxTemp << " C)" << std::endl;
+    return true;
+}
+
+/* FOLLOW MODE */
+
+volatile std::sig_atomic_t stopFollowing = 0;
+
+void onStopSignal(int) {
+    stopFollowing = 1;
+}
+
+// Function to start watching a directory for .tc0 files that are closed after writing
+// (or moved in); returns the inotify descriptor or -1
+int watchDirectory(const std::string &directory) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Error: Could not initialize inotify." << std::endl;
+        return -1;
     }
+    if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "Error: Could not watch directory: " << directory << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Function to classify new frames as they land in the directory until the shots are found
+// (one-shot mode) or the program is interrupted. `seen` holds the frames already classified as
+// readable; a frame caught before it was complete (short or invalid) stays out of it, so it is
+// classified again when its writer closes it.
+void followDirectory(int fd, const std::string &directory, std::set<std::string> &seen, const Config &config,
+                     FrameIndex *index, ShotDetector *detector) {
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
 
-    int xStart = config.drill_start_x;
-    int xEnd = config.drill_end_x;
-    int y = config.drill_start_y; // Assuming the drill is horizontal
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    while (!stopFollowing) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, 250);  // wake up regularly to notice a stop signal
+        if (ready <= 0) {
+            continue;
+        }
+
+        // Collect the .tc0 files of all pending events, then process them in sorted order
+        std::set<std::string> pending;
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char *p = buffer; p < buffer + length; ) {
+                auto *event = reinterpret_cast<struct inotify_event *>(p);
+                p += sizeof(struct inotify_event) + event->len;
+                if (event->len == 0) continue;
+                std::filesystem::path path = std::filesystem::path(directory) / event->name;
+                if (path.extension() == ".tc0" && !seen.count(path.string())) {
+                    pending.insert(path.string());
+                }
+            }
+        }
+        std::vector<std::string> newFiles(pending.begin(), pending.end());
 
-    float maxTemp = std::numeric_limits<float>::lowest();
-    for (int x = xStart; x <= xEnd; ++x) {
-        uint16_t temp = img.at<uint16_t>(y, x);
-        float temperature = static_cast<float>(temp) / 65535.0f * 256.0f; // Convert 16-bit value to temperature
-        maxTemp = std::max(maxTemp, temperature);
+        for (size_t i = 0; i < newFiles.size(); ++i) {
+            if (!detector) {
+                std::set<std::string> unreadable;
+                printResults(newFiles, i, i + 1, config, 1, index, &unreadable);
+                if (unreadable.empty()) {
+                    seen.insert(newFiles[i]);
+                }
+                continue;
+            }
+            std::vector<FrameStats> stats = runMtpfRange(newFiles, i, i + 1, config, 1, index);
+            if (stats[0].valid) {
+                seen.insert(newFiles[i]);
+            }
+            if (detector->feed(newFiles[i], classifyFrameStats(stats[0], config), stats[0])) {
+                reportShots(*detector, config);
+                return;
+            }
+        }
     }
-    return maxTemp;
 }
 
 // Function to sort files in a vector
@@ -184,26 +727,33 @@ void checkDirectoryExists(const std::string& directory) {
 // Main function
 int main(int argc, char *argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <directory> [-os|--oneShot]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <directory|archive.tcs> [-os|--oneShot] [--stride K] [-j N] [--no-index] [-f|--follow] [-a|--analyze] [--plan N | --shard K | --merge] [--video FILE [--video-range MIN:MAX] [--video-every K] [--video-fps F]] [--stats[=json]]" << std::endl;
+        std::cerr << "  -j N: worker threads, 0 = all hardware threads; more than the hardware threads (" << hardwareJobs() << ") are clamped to them" << std::endl;
         return 1;
     }
 
     std::string directory;
     bool oneShotMode = false;
+    int jobs = 1;
+    bool useIndex = true;
+    bool followMode = false;
+    size_t stride = 1;
 
     // Parse command line arguments
     std::vector<std::string> args(argv + 1, argv + argc);
+    // The session is a directory of .tc0 files or a packed .tcs archive (see mtpPack)
     auto dirIt = std::find_if(args.begin(), args.end(), [](const std::string& arg) {
-        return std::filesystem::is_directory(arg);
+        return std::filesystem::is_directory(arg) || (isArchivePath(arg) && std::filesystem::is_regular_file(arg));
     });
 
     if (dirIt != args.end()) {
         directory = *dirIt;
         args.erase(dirIt);
     } else {
-        std::cerr << "Error: No valid directory argument found." << std::endl;
+        std::cerr << "Error: No valid directory or archive argument found." << std::endl;
         return 1;
     }
+    bool archiveMode = !std::filesystem::is_directory(directory);
     
     auto osIt = std::find_if(args.begin(), args.end(), [](const std::string& arg) {
         return arg == "-os" || arg == "--oneShot";
@@ -213,52 +763,341 @@ int main(int argc, char *argv[]) {
         oneShotMode = true;
         args.erase(osIt);
     }
+
+    // -j N (or -jN): number of worker threads, 0 = all hardware threads (at most that many)
+    auto jobsIt = std::find_if(args.begin(), args.end(), [](const std::string& arg) {
+        return arg.rfind("-j", 0) == 0;
+    });
+
+    if (jobsIt != args.end()) {
+        std::string value = jobsIt->substr(2);
+        auto last = jobsIt + 1;
+        if (value.empty() && last != args.end()) {
+            value = *last;
+            ++last;
+        }
+        try {
+            jobs = std::stoi(value);
+        } catch (const std::exception &e) {
+            std::cerr << "Error: Invalid number of jobs: " << value << std::endl;
+            return 1;
+        }
+        jobs = clampJobs(jobs);
+        args.erase(jobsIt, last);
+    }
+
+    // --stride K: one-shot search on every K-th frame, refined around the hot/cold transitions
+    auto strideIt = std::find(args.begin(), args.end(), "--stride");
+    if (strideIt != args.end()) {
+        if (strideIt + 1 == args.end()) {
+            std::cerr << "Error: --stride needs a value" << std::endl;
+            return 1;
+        }
+        try {
+            int value = std::stoi(*(strideIt + 1));
+            if (value < 1) {
+                throw std::invalid_argument("stride");
+            }
+            stride = static_cast<size_t>(value);
+        } catch (const std::exception &e) {
+            std::cerr << "Error: Invalid stride: " << *(strideIt + 1) << std::endl;
+            return 1;
+        }
+        args.erase(strideIt, strideIt + 2);
+    }
+
+    // --stats[=json]: stage times and counters on stderr at exit
+    bool statsJson = false;
+    auto statsIt = std::find_if(args.begin(), args.end(), [&statsJson](const std::string& arg) {
+        return parseStatsFlag(arg, statsJson);
+    });
+    bool showStats = statsIt != args.end();
+    if (showStats) {
+        enableStats();
+        args.erase(statsIt);
+    }
+
+    // --no-index: do not read or write the per-directory frame index
+    auto indexIt = std::find(args.begin(), args.end(), "--no-index");
+    if (indexIt != args.end()) {
+        useIndex = false;
+        args.erase(indexIt);
+    }
+
+    // -f/--follow: keep watching the directory for new frames (live acquisition)
+    auto followIt = std::find_if(args.begin(), args.end(), [](const std::string& arg) {
+        return arg == "-f" || arg == "--follow";
+    });
+    if (followIt != args.end()) {
+        followMode = true;
+        args.erase(followIt);
+    }
+
+    // -a/--analyze: per-pixel maps and time series of the whole session instead of the frame list
+    auto analyzeIt = std::find_if(args.begin(), args.end(), [](const std::string& arg) {
+        return arg == "-a" || arg == "--analyze";
+    });
+    bool analyzeMode = analyzeIt != args.end();
+    if (analyzeMode) {
+        args.erase(analyzeIt);
+    }
+
+    // Sharded processing: --plan N splits the session into N shards (manifest), --shard K
+    // processes one of them (any node, any order), --merge prints the results of the whole session
+    long planShardCount = -1;
+    long shardIndex = -1;
+    for (const char *option : {"--plan", "--shard"}) {
+        auto optionIt = std::find(args.begin(), args.end(), option);
+        if (optionIt == args.end()) {
+            continue;
+        }
+        long &value = std::string(option) == "--plan" ? planShardCount : shardIndex;
+        try {
+            if (optionIt + 1 == args.end()) {
+                throw std::invalid_argument(option);
+            }
+            value = std::stol(*(optionIt + 1));
+        } catch (const std::exception &e) {
+            value = -1;
+        }
+        if (value < (std::string(option) == "--plan" ? 1 : 0)) {
+            std::cerr << "Error: Invalid value of " << option << std::endl;
+            return 1;
+        }
+        args.erase(optionIt, optionIt + 2);
+    }
+    auto mergeIt = std::find(args.begin(), args.end(), "--merge");
+    bool mergeMode = mergeIt != args.end();
+    if (mergeMode) {
+        args.erase(mergeIt);
+    }
+    int shardModes = (planShardCount >= 0) + (shardIndex >= 0) + mergeMode;
+
+    // --video FILE: render the session to a video (.avi: Motion JPEG, .mp4: MPEG-4), scaled to the
+    // session-global range or --video-range MIN:MAX, every --video-every K-th frame at --video-fps F
+    VideoOptions video;
+    for (const char *option : {"--video", "--video-range", "--video-every", "--video-fps"}) {
+        auto optionIt = std::find(args.begin(), args.end(), option);
+        if (optionIt == args.end()) {
+            continue;
+        }
+        std::string name = option;
+        std::string value = optionIt + 1 != args.end() ? *(optionIt + 1) : std::string();
+        bool valid = !value.empty();
+        try {
+            if (valid && name == "--video") {
+                video.path = value;
+            } else if (valid && name == "--video-range") {
+                size_t colon = value.find(':');
+                valid = colon != std::string::npos;
+                if (valid) {
+                    video.minTemp = std::stof(value.substr(0, colon));
+                    video.maxTemp = std::stof(value.substr(colon + 1));
+                    video.fixedRange = true;
+                    valid = video.maxTemp > video.minTemp;
+                }
+            } else if (valid && name == "--video-every") {
+                long every = std::stol(value);
+                valid = every >= 1;
+                video.every = valid ? static_cast<size_t>(every) : 1;
+            } else if (valid) {
+                video.fps = std::stod(value);
+                valid = video.fps > 0.0;
+            }
+        } catch (const std::exception &e) {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << "Error: Invalid value of " << option << std::endl;
+            return 1;
+        }
+        args.erase(optionIt, optionIt + 2);
+    }
+    bool videoMode = !video.path.empty();
     
     std::cout << "Dir: " << directory << ", oneShot mode: " << oneShotMode << std::endl;
     
     // Read config file
     Config config = readConfig("config.txt");
 
+    if (archiveMode && followMode) {
+        std::cerr << "Error: --follow needs a directory, not an archive." << std::endl;
+        return 1;
+    }
+    if (analyzeMode && (oneShotMode || followMode)) {
+        std::cerr << "Error: --analyze cannot be combined with --oneShot or --follow." << std::endl;
+        return 1;
+    }
+    if (videoMode && (oneShotMode || followMode || analyzeMode || shardModes > 0)) {
+        std::cerr << "Error: --video cannot be combined with --oneShot, --follow, --analyze or the shard options." << std::endl;
+        return 1;
+    }
+    if (!videoMode && (video.fixedRange || video.every > 1 || video.fps != VIDEO_FPS)) {
+        std::cerr << "Error: --video-range, --video-every and --video-fps need --video FILE." << std::endl;
+        return 1;
+    }
+    if (shardModes > 1 || (shardModes > 0 && (followMode || analyzeMode || stride > 1))) {
+        std::cerr << "Error: --plan, --shard and --merge exclude each other, --follow, --analyze and --stride." << std::endl;
+        return 1;
+    }
+
     try {
-        checkDirectoryExists(directory);
+        if (!archiveMode) {
+            checkDirectoryExists(directory);
+        }
     } catch (const std::runtime_error& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
 
-    std::vector<std::string> tc0Files;
-    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
-        if (entry.is_regular_file() && entry.path().extension() == ".tc0") {
-            tc0Files.push_back(entry.path().string());
+    // Start watching before listing the directory so that no frame falls in between
+    int watchFd = -1;
+    if (followMode) {
+        watchFd = watchDirectory(directory);
+        if (watchFd < 0) {
+            return 1;
         }
     }
 
-    // Sort the files
-    sortTc0Files(tc0Files);
+    // A shard or the merge works on the frames of the manifest, not on a new listing
+    std::string manifestPath = sessionPrefix(directory, archiveMode) + "_shards.txt";
+    ShardManifest manifest;
+    if (shardIndex >= 0 || mergeMode) {
+        if (!loadShardManifest(manifestPath, manifest)) {
+            return 1;
+        }
+        if (shardIndex >= static_cast<long>(manifest.shards())) {
+            std::cerr << "Error: The manifest has " << manifest.shards() << " shards: " << manifestPath << std::endl;
+            return 1;
+        }
+    }
 
-    if (oneShotMode) {
-        std::string beforeShot, afterShot;
-        if (findShots(tc0Files, beforeShot, afterShot)) {
-            std::cout << "Before shot: " << beforeShot << std::endl;
-            std::cout << "After shot: " << afterShot << std::endl;
+    std::vector<std::string> tc0Files;
+    if (shardIndex >= 0 || mergeMode) {
+        tc0Files = manifestFiles(manifest, directory, archiveMode);
+    } else if (archiveMode) {
+        // Frames of the archive, already in session order (no directory listing needed)
+        auto archive = TcsArchive::shared(directory);
+        if (!archive) {
+            return 1;
+        }
+        tc0Files.reserve(archive->size());
+        for (size_t i = 0; i < archive->size(); ++i) {
+            tc0Files.push_back(archiveMemberPath(directory, archive->frame(i).name));
+        }
+    } else {
+        for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".tc0") {
+                tc0Files.push_back(entry.path().string());
+            }
+        }
 
-            std::string beforeShotImage = beforeShot.substr(0, beforeShot.find_last_of('.')) + "_16bit.png";
-            std::string afterShotImage = afterShot.substr(0, afterShot.find_last_of('.')) + "_16bit.png";
+        // Sort the files
+        sortTc0Files(tc0Files);
+    }
 
-            float maxTempBefore = calculateMaxTemperatureOnDrillLine(beforeShotImage, config);
-            float maxTempAfter = calculateMaxTemperatureOnDrillLine(afterShotImage, config);
+    // Statistics of unchanged frames come from the index of the previous runs
+    // (for an archive the index is kept next to it: <archive>.tcs.mtpSeries.idx)
+    // Planning and merging decode no frames; shards run concurrently, so they only read the index
+    bool saveIndex = useIndex && shardModes == 0;
+    if (planShardCount > 0 || mergeMode) {
+        useIndex = false;
+    }
+    FrameIndex index;
+    std::string indexPath = archiveMode ? directory + FrameIndex::FILENAME
+                                        : (std::filesystem::path(directory) / FrameIndex::FILENAME).string();
+    if (useIndex) {
+        index.load(indexPath, frameGeometryKey(config));
+        std::vector<std::string> names;
+        names.reserve(tc0Files.size());
+        for (const auto &file : tc0Files) {
+            names.push_back(frameName(file));
+        }
+        index.retain(names);
+    }
+    FrameIndex *indexPtr = useIndex ? &index : nullptr;
 
-            std::cout << "Max temperature before shot: " << maxTempBefore << std::endl;
-            std::cout << "Max temperature after shot: " << maxTempAfter << std::endl;
+    int status = 0;
+    if (planShardCount > 0) {
+        std::vector<std::string> names;
+        names.reserve(tc0Files.size());
+        for (const auto &file : tc0Files) {
+            std::string archivePath, name;
+            names.push_back(splitArchiveMember(file, archivePath, name) ? name : frameName(file));
+        }
+        manifest = planShards(names, static_cast<size_t>(planShardCount));
+        if (!saveShardManifest(manifest, manifestPath)) {
+            return 1;
+        }
+        std::cout << "Manifest: " << manifestPath << " (" << names.size() << " frames, " << manifest.shards() << " shards)" << std::endl;
+        return 0;
+    } else if (shardIndex >= 0) {
+        if (!runShard(tc0Files, manifest, static_cast<size_t>(shardIndex), manifestPath, config, jobs, indexPtr)) {
+            status = 1;
+        }
+    } else if (mergeMode) {
+        if (!mergeShards(tc0Files, manifest, manifestPath, config, oneShotMode)) {
+            status = 1;
+        }
+    } else if (videoMode) {
+        if (!exportVideo(tc0Files, config, jobs, indexPtr, video)) {
+            status = 1;
+        }
+    } else if (analyzeMode) {
+        // Every frame is decoded for the pixel maps; the index only receives the new statistics
+        if (!analyzeSession(tc0Files, config, jobs, indexPtr, sessionPrefix(directory, archiveMode))) {
+            status = 1;
+        }
+    } else if (oneShotMode) {
+        ShotDetector detector;
+        std::set<std::string> unreadable;
+        bool found = stride > 1 ? findShotsStrided(tc0Files, config, jobs, indexPtr, stride, detector, &unreadable)
+                                : findShots(tc0Files, config, jobs, indexPtr, detector, &unreadable);
+        if (found) {
+            reportShots(detector, config);
+        } else if (followMode) {
+            // Keep the state machine running on the frames that are still being recorded (and on
+            // those that were not complete yet when they were listed)
+            std::set<std::string> seen(tc0Files.begin(), tc0Files.end());
+            for (const auto &file : unreadable) {
+                seen.erase(file);
+            }
+            followDirectory(watchFd, directory, seen, config, indexPtr, &detector);
+            if (!detector.done()) {
+                std::cout << "No suitable shots found." << std::endl;
+            }
         } else {
             std::cout << "No suitable shots found." << std::endl;
         }
     } else {
-        for (const auto &file : tc0Files) {
-            int result = runMtpf(file);
-            std::cout << file << ": " << result << std::endl;
+        size_t window = scanWindow(jobs);
+        std::set<std::string> unreadable;
+        for (size_t begin = 0; begin < tc0Files.size(); begin += window) {
+            size_t end = std::min(begin + window, tc0Files.size());
+            printResults(tc0Files, begin, end, config, jobs, indexPtr, &unreadable);
+        }
+
+        if (followMode) {
+            // Frames that were not complete yet when they were listed are classified again once closed
+            std::set<std::string> seen(tc0Files.begin(), tc0Files.end());
+            for (const auto &file : unreadable) {
+                seen.erase(file);
+            }
+            followDirectory(watchFd, directory, seen, config, indexPtr, nullptr);
         }
     }
 
-    return 0;
+    if (watchFd >= 0) {
+        close(watchFd);
+    }
+
+    if (saveIndex) {
+        index.save(indexPath);
+    }
+
+    if (showStats) {
+        printStats(std::cerr, statsJson);
+    }
+
+    return status;
 }